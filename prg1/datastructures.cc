@@ -1,581 +1,990 @@
-// Datastructures.cc
-
-
-
-#include "datastructures.hh"
-
-#include <random>
-
-#include <cmath>
-
-#include <queue>
-
-std::minstd_rand rand_engine; // Reasonably quick pseudo-random generator
-
-template <typename Type>
-Type random_in_range(Type start, Type end)
-{
-    auto range = end-start;
-    ++range;
-
-    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine);
-
-    return static_cast<Type>(start+num);
-}
-
-// Modify the code below to implement the functionality of the class.
-// Also remove comments from the parameter names when you implement
-// an operation (Commenting out parameter name prevents compiler from
-// warning about unused parameters on operations you haven't yet implemented.)
-
-Datastructures::Datastructures()
-{
-    // Write any initialization you need here
-}
-
-Datastructures::~Datastructures()
-{
-    // Write any cleanup you need here
-}
-
-unsigned int Datastructures::get_affiliation_count()
-{
-    return affiliations_vector.size();
-}
-
-void Datastructures::clear_all()
-{
-    affiliations_vector.clear();
-    affiliation_publication.clear();
-    affiliation_map.clear();
-    publications_vector.clear();
-    publications_vector.clear();
-    affiliations_distance.clear();
-    affiliations_set.clear();
-    coord_to_affiliation.clear();
-}
-
-std::vector<AffiliationID> Datastructures::get_all_affiliations()
-{
-    return affiliations_vector;
-}
-
-bool Datastructures::add_affiliation(AffiliationID id, const Name &name, Coord xy)
-{
-    auto it = affiliation_publication.find(id);
-
-    if(it == affiliation_publication.end()){
-        affiliation_publication[id];
-        affiliations_vector.push_back(id);
-
-
-        Affiliation new_affiliation;
-        new_affiliation.id = id;
-        new_affiliation.name = name;
-        new_affiliation.xy = xy;
-        affiliation_map.insert({id,new_affiliation});
-        affiliations_distance.insert(new_affiliation);
-        coord_to_affiliation[xy] = id;
-        affiliations_set.insert(new_affiliation);
-        return true;
-    }
-    return false;
-}
-
-Name Datastructures::get_affiliation_name(AffiliationID id)
-{
-   auto it = affiliation_map.find(id);
-   if(it != affiliation_map.end()){
-       return it->second.name;
-   }
-   else{
-       return NO_NAME;
-   }
-}
-
-Coord Datastructures::get_affiliation_coord(AffiliationID id)
-{
-    auto it = affiliation_map.find(id);
-    if(it != affiliation_map.end()){
-        return it->second.xy;
-    }
-    else{
-        return NO_COORD;
-    }
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_alphabetically()
-{
-    static bool is_ordered = false;
-
-    if(!is_ordered){
-        affiliations_set = std::set<Affiliation,AffiliationNameComparator>(affiliations_set.begin(),affiliations_set.end());
-        is_ordered = true;
-    }
-
-
-    std::vector<AffiliationID> sorted_ids;
-    for (const auto& affiliation : affiliations_set) {
-        sorted_ids.push_back(affiliation.id);
-    }
-
-    return sorted_ids;
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_distance_increasing()
-{
-    static bool is_ordered = false;
-
-    if(!is_ordered){
-        affiliations_distance = std::set<Affiliation,DistanceComparator>(affiliations_distance.begin(),affiliations_distance.end());
-        is_ordered = true;
-    }
-
-    std::vector<AffiliationID> sorted_affiliationids;
-    for (const auto& affiliation : affiliations_distance) {
-        sorted_affiliationids.push_back(affiliation.id);
-    }
-    return sorted_affiliationids;
-}
-
-AffiliationID Datastructures::find_affiliation_with_coord(Coord xy)
-{
-    auto it = coord_to_affiliation.find(xy);
-    if (it != coord_to_affiliation.end()) {
-        return it->second;
-    }
-    else {
-        return NO_AFFILIATION;
-    }
-}
-
-bool Datastructures::change_affiliation_coord(AffiliationID id, Coord newcoord)
-{
-    auto it = affiliation_map.find(id);
-
-        if (it != affiliation_map.end()) {
-
-            Affiliation& affiliation = it->second;
-
-            affiliations_distance.erase(affiliation);
-
-
-            Coord oldcoord = affiliation.xy;
-            affiliation.xy = newcoord;
-
-            affiliations_distance.insert(affiliation);
-
-
-
-
-            coord_to_affiliation.erase(oldcoord);
-            coord_to_affiliation[newcoord] = id;
-
-            return true;
-        }
-        else {
-
-            return false;
-        }
-}
-
-bool Datastructures::add_publication(PublicationID id, const std::string& title, Year year, const std::vector<AffiliationID>& affiliations)
-{
-
-    if (publication_map.find(id) != publication_map.end()) {
-        return false;
-    }
-
-
-    Publication new_publication;
-    new_publication.id = id;
-    new_publication.title = title;
-    new_publication.publication_year = year;
-    new_publication.parent = nullptr;
-
-
-    for (const AffiliationID& affiliation_id : affiliations) {
-        new_publication.publication_affiliation.insert(affiliation_id);
-        affiliation_publication[affiliation_id].insert(id);
-    }
-
-
-    publications_vector.push_back(id);
-    publication_map[id] = new_publication;
-
-    return true;
-}
-
-std::vector<PublicationID> Datastructures::all_publications()
-{
-    return publications_vector;
-}
-
-Name Datastructures::get_publication_name(PublicationID id)
-{
-
-    auto publication_it = publication_map.find(id);
-    if (publication_it != publication_map.end()) {
-
-        return publication_it->second.title;
-    }
-    else {
-
-        return NO_NAME;
-    }
-}
-
-Year Datastructures::get_publication_year(PublicationID id)
-{
-    auto publication_it = publication_map.find(id);
-    if(publication_it != publication_map.end()){
-        return publication_it ->second.publication_year;
-    }
-    else{
-        return NO_YEAR;
-    }
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations(PublicationID id)
-{
-    auto it = publication_map.find(id);
-
-    if (it != publication_map.end()) {
-
-        const Publication& publication = it->second;
-
-
-        std::vector<AffiliationID> result_vector(publication.publication_affiliation.begin(), publication.publication_affiliation.end());
-
-        return result_vector;
-    } else {
-
-        return {NO_AFFILIATION};
-    }
-}
-
-bool Datastructures::add_reference(PublicationID id, PublicationID parentid)
-{
-    auto it_child = publication_map.find(id);
-    auto it_parent = publication_map.find(parentid);
-
-
-    if (it_child != publication_map.end() && it_parent != publication_map.end()) {
-
-        it_child->second.parent = &(it_parent->second);
-        it_parent->second.references.insert(&(it_child->second));
-        return true;
-    } else {
-
-        return false;
-    }
-}
-
-std::vector<PublicationID> Datastructures::get_direct_references(PublicationID id)
-{
-    auto it = publication_map.find(id);
-
-    if (it != publication_map.end()) {
-
-        const Publication& publication = it->second;
-
-
-        std::vector<PublicationID> direct_references(publication.references.size());
-        std::transform(publication.references.begin(), publication.references.end(), direct_references.begin(),
-                       [](const Publication* ref) { return ref->id; });
-
-        return direct_references;
-    } else {
-
-        return {NO_PUBLICATION};
-    }
-}
-
-bool Datastructures::add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid)
-{
-
-    auto publication_it = publication_map.find(publicationid);
-    if (publication_it == publication_map.end()) {
-
-        return false;
-    }
-
-
-    auto affiliation_it = affiliation_map.find(affiliationid);
-    if (affiliation_it == affiliation_map.end()) {
-
-        return false;
-    }
-
-
-    Publication& publication = publication_it->second;
-    publication.publication_affiliation.insert(affiliationid);
-
-
-    affiliation_publication[affiliationid].insert(publicationid);
-
-    return true;
-}
-
-std::vector<PublicationID> Datastructures::get_publications(AffiliationID id)
-{
-
-    if (affiliation_publication.find(id) == affiliation_publication.end()) {
-
-        return {NO_PUBLICATION};
-    }
-
-
-    const std::unordered_set<PublicationID>& publications = affiliation_publication[id];
-
-
-    std::vector<PublicationID> publication_vector(publications.begin(), publications.end());
-
-    return publication_vector;
-}
-
-PublicationID Datastructures::get_parent(PublicationID id)
-{
-
-    auto publication_it = publication_map.find(id);
-    if (publication_it == publication_map.end()) {
-
-        return NO_PUBLICATION;
-    }
-
-
-    const Publication* parent_publication = publication_it->second.parent;
-
-    if (parent_publication) {
-
-        return parent_publication->id;
-    } else {
-
-        return NO_PUBLICATION;
-    }
-}
-
-std::vector<std::pair<Year, PublicationID>> Datastructures::get_publications_after(AffiliationID affiliationid, Year year)
-{
-
-    auto affiliation_it = affiliation_map.find(affiliationid);
-    if (affiliation_it == affiliation_map.end()) {
-
-        return {{NO_YEAR, NO_PUBLICATION}};
-    }
-
-
-    const std::unordered_set<PublicationID>& publications = affiliation_publication[affiliationid];
-
-
-    std::vector<std::pair<Year, PublicationID>> result;
-
-
-    for (PublicationID publication_id : publications) {
-
-        auto publication_it = publication_map.find(publication_id);
-        if (publication_it != publication_map.end()) {
-            const Publication& publication = publication_it->second;
-
-
-            if (publication.publication_year >= year) {
-
-                result.push_back({publication.publication_year, publication.id});
-            }
-        }
-    }
-
-
-    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
-        if (a.first != b.first) {
-            return a.first < b.first;
-        } else {
-            return a.second < b.second;
-        }
-    });
-
-    return result;
-}
-
-std::vector<PublicationID> Datastructures::get_referenced_by_chain(PublicationID id) {
-
-    auto publication_it = publication_map.find(id);
-    if (publication_it == publication_map.end()) {
-
-        return {NO_PUBLICATION};
-    }
-
-    std::vector<PublicationID> referenced_chain;
-
-
-    std::function<void(Publication*)> traverse_chain = [&](Publication* pub) {
-        if (pub != nullptr) {
-
-            referenced_chain.push_back(pub->id);
-
-
-            traverse_chain(pub->parent);
-        }
-    };
-
-
-    traverse_chain(publication_it->second.parent);
-
-    return referenced_chain;
-}
-
-//Optional functions
-std::vector<PublicationID> Datastructures::get_all_references(PublicationID id)
-{
-
-    auto publication_it = publication_map.find(id);
-    if (publication_it == publication_map.end()) {
-
-        return {NO_PUBLICATION};
-    }
-
-
-    std::vector<PublicationID> all_references;
-
-
-    std::queue<Publication*> bfs_queue;
-
-
-    std::unordered_set<PublicationID> visited;
-
-
-    bfs_queue.push(&(publication_it->second));
-    visited.insert(id);
-
-
-    while (!bfs_queue.empty()) {
-        Publication* current_publication = bfs_queue.front();
-        bfs_queue.pop();
-
-        if (current_publication->id != id) {
-            all_references.push_back(current_publication->id);
-        }
-
-
-        for (Publication* reference : current_publication->references) {
-            if (visited.find(reference->id) == visited.end()) {
-                bfs_queue.push(reference);
-                visited.insert(reference->id);
-            }
-        }
-    }
-
-    return all_references;
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_closest_to(Coord xy)
-{
-    if(affiliations_set.empty()){
-        return {};
-    }
-
-    std::vector<AffiliationID> closest_affiliations;
-
-    auto comparator = [&](const Affiliation& a, const Affiliation& b){
-        return calculate_distance(a.xy,xy) < calculate_distance(b.xy,xy);
-    };
-
-    std::set<Affiliation, decltype(comparator)> close_affiliations(comparator);
-
-    for(const auto& affiliation: affiliations_set){
-        close_affiliations.insert(affiliation);
-
-        if(close_affiliations.size()> 3){
-            close_affiliations.erase(std::prev(close_affiliations.end()));
-        }
-    }
-
-    for(const auto& affiliation: close_affiliations){
-        closest_affiliations.push_back(affiliation.id);
-    }
-
-    return closest_affiliations;
-}
-
-bool Datastructures::remove_affiliation(AffiliationID id)
-{
-    auto iter = affiliation_map.find(id);
-
-    if(iter == affiliation_map.end()){
-        return false;
-    }
-
-    affiliation_map.erase(id);
-
-    affiliation_publication.erase(id);
-
-    affiliations_vector.erase(std::remove(affiliations_vector.begin(),affiliations_vector.end(),id),affiliations_vector.end());
-
-
-    for(const PublicationID& publication_id : publications_vector){
-        auto publication_iter = publication_map.find(publication_id);
-
-        if(publication_iter != publication_map.end()){
-            Publication& publication = publication_iter->second;
-
-            publication.publication_affiliation.erase(id);
-        }
-    }
-
-    affiliations_set.erase(std::find_if(affiliations_set.begin(),affiliations_set.end(),[id](const Affiliation& a){
-        return a.id == id;}));
-
-    affiliations_distance.erase(std::find_if(affiliations_distance.begin(),affiliations_distance.end(),[id](const Affiliation& a){
-        return a.id == id;}));
-
-    return true;
-}
-
-PublicationID Datastructures::get_closest_common_parent(PublicationID id1, PublicationID id2)
-{
-    auto iter1 = publication_map.find(id1);
-    auto iter2 = publication_map.find(id2);
-
-    if(iter1 == publication_map.end()|| iter2 == publication_map.end()){
-        return NO_PUBLICATION;
-    }
-
-    std::vector<PublicationID> chain1 = get_referenced_by_chain(id1);
-    std::vector<PublicationID> chain2 = get_referenced_by_chain(id2);
-
-    PublicationID common_parent = find_closest_common_parent(chain1,chain2);
-
-    return common_parent;
-}
-
-bool Datastructures::remove_publication(PublicationID publicationid)
-{
-    auto iter = publication_map.find(publicationid);
-
-    if(iter == publication_map.end()){
-        return false;
-    }
-
-
-
-    const Publication& publication_toremove = iter->second;
-
-    for(auto&entry : publication_map){
-        auto& other_publication = entry.second;
-        if(other_publication.parent == &publication_toremove){
-            other_publication.parent = nullptr;
-        }
-    }
-
-    for(auto& affiliation_entry : affiliation_publication){
-        auto& publication_set = affiliation_entry.second;
-        publication_set.erase(publicationid);
-    }
-
-    publication_map.erase(publicationid);
-    publications_vector.erase(std::remove(publications_vector.begin(),publications_vector.end(),publicationid),publications_vector.end());
-
-    return true;
-}
-
-
+// Datastructures.cc
+
+
+
+#include "datastructures.hh"
+
+#include <random>
+
+#include <cmath>
+
+#include <queue>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+std::minstd_rand rand_engine; // Reasonably quick pseudo-random generator
+
+template <typename Type>
+Type random_in_range(Type start, Type end)
+{
+    auto range = end-start;
+    ++range;
+
+    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine);
+
+    return static_cast<Type>(start+num);
+}
+
+// Modify the code below to implement the functionality of the class.
+// Also remove comments from the parameter names when you implement
+// an operation (Commenting out parameter name prevents compiler from
+// warning about unused parameters on operations you haven't yet implemented.)
+
+Datastructures::Datastructures()
+{
+    // Write any initialization you need here
+    set_distance_kernel("auto");
+}
+
+Datastructures::~Datastructures()
+{
+    // Write any cleanup you need here
+}
+
+unsigned int Datastructures::get_affiliation_count()
+{
+    return affiliations_vector.size();
+}
+
+void Datastructures::clear_all()
+{
+    affiliations.clear();
+    affiliations_vector.clear();
+    affiliation_publication.clear();
+    affiliation_map.clear();
+    publications_vector.clear();
+    publications_vector.clear();
+    affiliations_distance.clear();
+    affiliations_set.clear();
+    coord_to_affiliation.clear();
+    distance_scratch.clear();
+}
+
+std::vector<AffiliationID> Datastructures::get_all_affiliations()
+{
+    std::vector<AffiliationID> ids;
+    ids.reserve(affiliations_vector.size());
+    for (AffiliationHandle handle : affiliations_vector) {
+        ids.emplace_back(affiliations.id(handle));
+    }
+    return ids;
+}
+
+bool Datastructures::add_affiliation(AffiliationID id, const Name &name, Coord xy)
+{
+    auto it = affiliation_publication.find(id);
+
+    if(it == affiliation_publication.end()){
+        affiliation_publication[id];
+
+        AffiliationHandle handle = affiliations.append(id, name, xy);
+        affiliations_vector.push_back(handle);
+        affiliation_map.insert({id,handle});
+        affiliations_distance.insert(handle);
+        coord_to_affiliation.insert(handle);
+        affiliations_set.insert(handle);
+        return true;
+    }
+    return false;
+}
+
+Name Datastructures::get_affiliation_name(AffiliationID id)
+{
+   auto it = affiliation_map.find(id);
+   if(it != affiliation_map.end()){
+       return Name(affiliations.name(it->second));
+   }
+   else{
+       return NO_NAME;
+   }
+}
+
+Coord Datastructures::get_affiliation_coord(AffiliationID id)
+{
+    auto it = affiliation_map.find(id);
+    if(it != affiliation_map.end()){
+        return affiliations.xy(it->second);
+    }
+    else{
+        return NO_COORD;
+    }
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_alphabetically()
+{
+    std::vector<AffiliationID> sorted_ids;
+    sorted_ids.reserve(affiliations_set.size());
+    for (AffiliationHandle handle : affiliations_set) {
+        sorted_ids.emplace_back(affiliations.id(handle));
+    }
+
+    return sorted_ids;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_distance_increasing()
+{
+    std::vector<AffiliationID> sorted_affiliationids;
+    sorted_affiliationids.reserve(affiliations_distance.size());
+    for (AffiliationHandle handle : affiliations_distance) {
+        sorted_affiliationids.emplace_back(affiliations.id(handle));
+    }
+    return sorted_affiliationids;
+}
+
+AffiliationID Datastructures::find_affiliation_with_coord(Coord xy)
+{
+    auto it = coord_to_affiliation.lower_bound(xy);
+    if (it != coord_to_affiliation.end() && affiliations.xy(*it) == xy) {
+        return AffiliationID(affiliations.id(*it));
+    }
+    else {
+        return NO_AFFILIATION;
+    }
+}
+
+bool Datastructures::change_affiliation_coord(AffiliationID id, Coord newcoord)
+{
+    auto it = affiliation_map.find(id);
+
+        if (it != affiliation_map.end()) {
+
+            AffiliationHandle handle = it->second;
+
+            // The sets are keyed by the coordinates, so the handle is
+            // taken out while they change
+            affiliations_distance.erase(handle);
+            coord_to_affiliation.erase(handle);
+
+            affiliations.set_xy(handle, newcoord);
+
+            affiliations_distance.insert(handle);
+            coord_to_affiliation.insert(handle);
+
+            return true;
+        }
+        else {
+
+            return false;
+        }
+}
+
+bool Datastructures::add_publication(PublicationID id, const std::string& title, Year year, const std::vector<AffiliationID>& affiliations)
+{
+
+    if (publication_map.find(id) != publication_map.end()) {
+        return false;
+    }
+
+
+    Publication new_publication;
+    new_publication.id = id;
+    new_publication.title = title;
+    new_publication.publication_year = year;
+    new_publication.parent = nullptr;
+
+
+    for (const AffiliationID& affiliation_id : affiliations) {
+        new_publication.publication_affiliation.insert(affiliation_id);
+        affiliation_publication[affiliation_id].insert(id);
+    }
+
+
+    publications_vector.push_back(id);
+    publication_map[id] = new_publication;
+
+    return true;
+}
+
+std::vector<PublicationID> Datastructures::all_publications()
+{
+    return publications_vector;
+}
+
+Name Datastructures::get_publication_name(PublicationID id)
+{
+
+    auto publication_it = publication_map.find(id);
+    if (publication_it != publication_map.end()) {
+
+        return publication_it->second.title;
+    }
+    else {
+
+        return NO_NAME;
+    }
+}
+
+Year Datastructures::get_publication_year(PublicationID id)
+{
+    auto publication_it = publication_map.find(id);
+    if(publication_it != publication_map.end()){
+        return publication_it ->second.publication_year;
+    }
+    else{
+        return NO_YEAR;
+    }
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations(PublicationID id)
+{
+    auto it = publication_map.find(id);
+
+    if (it != publication_map.end()) {
+
+        const Publication& publication = it->second;
+
+
+        std::vector<AffiliationID> result_vector(publication.publication_affiliation.begin(), publication.publication_affiliation.end());
+
+        return result_vector;
+    } else {
+
+        return {NO_AFFILIATION};
+    }
+}
+
+bool Datastructures::add_reference(PublicationID id, PublicationID parentid)
+{
+    auto it_child = publication_map.find(id);
+    auto it_parent = publication_map.find(parentid);
+
+
+    if (it_child != publication_map.end() && it_parent != publication_map.end()) {
+
+        it_child->second.parent = &(it_parent->second);
+        it_parent->second.references.insert(&(it_child->second));
+        return true;
+    } else {
+
+        return false;
+    }
+}
+
+std::vector<PublicationID> Datastructures::get_direct_references(PublicationID id)
+{
+    auto it = publication_map.find(id);
+
+    if (it != publication_map.end()) {
+
+        const Publication& publication = it->second;
+
+
+        std::vector<PublicationID> direct_references(publication.references.size());
+        std::transform(publication.references.begin(), publication.references.end(), direct_references.begin(),
+                       [](const Publication* ref) { return ref->id; });
+
+        return direct_references;
+    } else {
+
+        return {NO_PUBLICATION};
+    }
+}
+
+bool Datastructures::add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid)
+{
+
+    auto publication_it = publication_map.find(publicationid);
+    if (publication_it == publication_map.end()) {
+
+        return false;
+    }
+
+
+    auto affiliation_it = affiliation_map.find(affiliationid);
+    if (affiliation_it == affiliation_map.end()) {
+
+        return false;
+    }
+
+
+    Publication& publication = publication_it->second;
+    publication.publication_affiliation.insert(affiliationid);
+
+
+    affiliation_publication[affiliationid].insert(publicationid);
+
+    return true;
+}
+
+std::vector<PublicationID> Datastructures::get_publications(AffiliationID id)
+{
+
+    if (affiliation_publication.find(id) == affiliation_publication.end()) {
+
+        return {NO_PUBLICATION};
+    }
+
+
+    const std::unordered_set<PublicationID>& publications = affiliation_publication[id];
+
+
+    std::vector<PublicationID> publication_vector(publications.begin(), publications.end());
+
+    return publication_vector;
+}
+
+PublicationID Datastructures::get_parent(PublicationID id)
+{
+
+    auto publication_it = publication_map.find(id);
+    if (publication_it == publication_map.end()) {
+
+        return NO_PUBLICATION;
+    }
+
+
+    const Publication* parent_publication = publication_it->second.parent;
+
+    if (parent_publication) {
+
+        return parent_publication->id;
+    } else {
+
+        return NO_PUBLICATION;
+    }
+}
+
+std::vector<std::pair<Year, PublicationID>> Datastructures::get_publications_after(AffiliationID affiliationid, Year year)
+{
+
+    auto affiliation_it = affiliation_map.find(affiliationid);
+    if (affiliation_it == affiliation_map.end()) {
+
+        return {{NO_YEAR, NO_PUBLICATION}};
+    }
+
+
+    const std::unordered_set<PublicationID>& publications = affiliation_publication[affiliationid];
+
+
+    std::vector<std::pair<Year, PublicationID>> result;
+
+
+    for (PublicationID publication_id : publications) {
+
+        auto publication_it = publication_map.find(publication_id);
+        if (publication_it != publication_map.end()) {
+            const Publication& publication = publication_it->second;
+
+
+            if (publication.publication_year >= year) {
+
+                result.push_back({publication.publication_year, publication.id});
+            }
+        }
+    }
+
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        } else {
+            return a.second < b.second;
+        }
+    });
+
+    return result;
+}
+
+std::vector<PublicationID> Datastructures::get_referenced_by_chain(PublicationID id) {
+
+    auto publication_it = publication_map.find(id);
+    if (publication_it == publication_map.end()) {
+
+        return {NO_PUBLICATION};
+    }
+
+    std::vector<PublicationID> referenced_chain;
+
+
+    std::function<void(Publication*)> traverse_chain = [&](Publication* pub) {
+        if (pub != nullptr) {
+
+            referenced_chain.push_back(pub->id);
+
+
+            traverse_chain(pub->parent);
+        }
+    };
+
+
+    traverse_chain(publication_it->second.parent);
+
+    return referenced_chain;
+}
+
+//Optional functions
+std::vector<PublicationID> Datastructures::get_all_references(PublicationID id)
+{
+
+    auto publication_it = publication_map.find(id);
+    if (publication_it == publication_map.end()) {
+
+        return {NO_PUBLICATION};
+    }
+
+
+    std::vector<PublicationID> all_references;
+
+
+    std::queue<Publication*> bfs_queue;
+
+
+    std::unordered_set<PublicationID> visited;
+
+
+    bfs_queue.push(&(publication_it->second));
+    visited.insert(id);
+
+
+    while (!bfs_queue.empty()) {
+        Publication* current_publication = bfs_queue.front();
+        bfs_queue.pop();
+
+        if (current_publication->id != id) {
+            all_references.push_back(current_publication->id);
+        }
+
+
+        for (Publication* reference : current_publication->references) {
+            if (visited.find(reference->id) == visited.end()) {
+                bfs_queue.push(reference);
+                visited.insert(reference->id);
+            }
+        }
+    }
+
+    return all_references;
+}
+
+namespace
+{
+// Squared distances from a point to every slot of the coordinate columns.
+// The differences are taken as unsigned max - min, which fits 32 bits, and
+// their squares fit 64 bits. The sum of the two squares can still exceed
+// LLONG_MAX when a difference is 2^31 or more (only possible with
+// coordinates of both signs), so it saturates at LLONG_MAX: such far away
+// slots compare equal to each other but remain farther than the rest.
+void scalar_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        unsigned long long dx = xs[i] > from.x ? 0ULL + xs[i] - from.x : 0ULL + from.x - xs[i];
+        unsigned long long dy = ys[i] > from.y ? 0ULL + ys[i] - from.y : 0ULL + from.y - ys[i];
+        unsigned long long square = dx * dx;
+        unsigned long long sum = square + dy * dy;
+        bool saturated = sum < square || sum > static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+        distances[i] = saturated ? std::numeric_limits<long long>::max() : static_cast<long long>(sum);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_DISTANCE_KERNELS
+
+// The vector kernels don't saturate. They collect the top bits of all the
+// differences instead, and leave the call to the scalar kernel if any is
+// set, since below 2^31 the sum of two squares stays below 2^63.
+
+// |a - b| of signed 32 bit lanes as unsigned 32 bit lanes
+__attribute__((target("sse2"))) inline __m128i sse2_abs_diff(__m128i a, __m128i b)
+{
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    __m128i high = _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+    __m128i low = _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+    return _mm_sub_epi32(high, low);
+}
+
+__attribute__((target("sse2")))
+void sse2_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    __m128i from_x = _mm_set1_epi32(from.x);
+    __m128i from_y = _mm_set1_epi32(from.y);
+    __m128i differences = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i dx = sse2_abs_diff(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i)), from_x);
+        __m128i dy = sse2_abs_diff(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i)), from_y);
+        differences = _mm_or_si128(differences, _mm_or_si128(dx, dy));
+        // 32 x 32 -> 64 bit products of the even lanes, then of the odd ones
+        __m128i even = _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy));
+        dx = _mm_srli_epi64(dx, 32);
+        dy = _mm_srli_epi64(dy, 32);
+        __m128i odd = _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i), _mm_unpacklo_epi64(even, odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i + 2), _mm_unpackhi_epi64(even, odd));
+    }
+    if (_mm_movemask_ps(_mm_castsi128_ps(differences)) != 0) {
+        i = 0;
+    }
+    scalar_square_distances(xs + i, ys + i, count - i, from, distances + i);
+}
+
+__attribute__((target("avx2")))
+void avx2_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    __m256i from_x = _mm256_set1_epi32(from.x);
+    __m256i from_y = _mm256_set1_epi32(from.y);
+    __m256i differences = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i));
+        __m256i dx = _mm256_sub_epi32(_mm256_max_epi32(x, from_x), _mm256_min_epi32(x, from_x));
+        __m256i dy = _mm256_sub_epi32(_mm256_max_epi32(y, from_y), _mm256_min_epi32(y, from_y));
+        differences = _mm256_or_si256(differences, _mm256_or_si256(dx, dy));
+        __m256i even = _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy));
+        dx = _mm256_srli_epi64(dx, 32);
+        dy = _mm256_srli_epi64(dy, 32);
+        __m256i odd = _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy));
+        // Unpacking interleaves within 128 bit halves: [0 1 | 4 5] and [2 3 | 6 7]
+        __m256i low = _mm256_unpacklo_epi64(even, odd);
+        __m256i high = _mm256_unpackhi_epi64(even, odd);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + i), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + i + 4), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    if (_mm256_movemask_ps(_mm256_castsi256_ps(differences)) != 0) {
+        i = 0;
+    }
+    scalar_square_distances(xs + i, ys + i, count - i, from, distances + i);
+}
+#endif
+
+bool cpu_has_kernel(const std::string& name)
+{
+#ifdef HAS_X86_DISTANCE_KERNELS
+    __builtin_cpu_init();
+    if (name == "avx2") {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (name == "sse2") {
+        return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return name == "scalar";
+}
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_closest_to(Coord xy)
+{
+    return get_affiliations_closest_to_k(xy, 3);
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_closest_to_k(Coord xy, unsigned int k)
+{
+    std::vector<AffiliationID> closest_affiliations;
+    for(AffiliationHandle handle: nearest(xy, k, std::numeric_limits<long long>::max())){
+        closest_affiliations.emplace_back(affiliations.id(handle));
+    }
+    return closest_affiliations;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_within_radius(Coord xy, int radius)
+{
+    if(radius < 0){
+        return {};
+    }
+
+    std::vector<AffiliationID> close_affiliations;
+    for(AffiliationHandle handle: nearest(xy, affiliations.size(), static_cast<long long>(radius) * radius)){
+        close_affiliations.emplace_back(affiliations.id(handle));
+    }
+    return close_affiliations;
+}
+
+std::string Datastructures::set_distance_kernel(const std::string& name)
+{
+    // Widest first, so that "auto" takes the first one available
+    static const std::pair<const char*, DistanceKernel> kernels[] = {
+        {"avx2", DistanceKernel::AVX2}, {"sse2", DistanceKernel::SSE2}, {"scalar", DistanceKernel::SCALAR}};
+    for(const auto& [kernel_name, kernel] : kernels){
+        if((name == "auto" || name == kernel_name) && cpu_has_kernel(kernel_name)){
+            distance_kernel = kernel;
+            return kernel_name;
+        }
+    }
+    return "";
+}
+
+void Datastructures::square_distances(Coord xy)
+{
+    distance_scratch.resize(affiliations.size());
+    const int* xs = affiliations.xs.data();
+    const int* ys = affiliations.ys.data();
+    switch(distance_kernel){
+#ifdef HAS_X86_DISTANCE_KERNELS
+    case DistanceKernel::AVX2:
+        avx2_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+    case DistanceKernel::SSE2:
+        sse2_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+#endif
+    default:
+        scalar_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+    }
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_in_rect(Coord min, Coord max)
+{
+    std::vector<AffiliationID> inside;
+    if(min.x > max.x || min.y > max.y){
+        return inside;
+    }
+
+    // The set is ordered by y, then x, so the rectangle is a run of each of
+    // its rows. Coordinates outside the x range are skipped with one lookup.
+    auto it = coord_to_affiliation.lower_bound(min);
+    while(it != coord_to_affiliation.end() && affiliations.ys[*it] <= max.y){
+        Coord coord = affiliations.xy(*it);
+        if(coord.x < min.x){
+            it = coord_to_affiliation.lower_bound(Coord{min.x, coord.y});
+        }
+        else if(coord.x > max.x){
+            if(coord.y == std::numeric_limits<int>::max()){
+                break;
+            }
+            it = coord_to_affiliation.lower_bound(Coord{min.x, coord.y + 1});
+        }
+        else{
+            inside.emplace_back(affiliations.id(*it));
+            ++it;
+        }
+    }
+    return inside;
+}
+
+std::pair<Coord, Coord> Datastructures::get_affiliation_extent()
+{
+    if(affiliations.extent.empty()){
+        return {NO_COORD, NO_COORD};
+    }
+    return {affiliations.extent.min, affiliations.extent.max};
+}
+
+namespace
+{
+// Reserves room for count elements, at least doubling the capacity so that
+// many small batches don't reallocate every time
+template <typename Type>
+void grow_capacity(std::vector<Type>& values, std::size_t count)
+{
+    if(count > values.capacity()){
+        values.reserve(std::max(count, 2 * values.capacity()));
+    }
+}
+
+template <typename Key, typename Value>
+void grow_capacity(std::unordered_map<Key, Value>& map, std::size_t count)
+{
+    if(count > map.bucket_count() * map.max_load_factor()){
+        map.reserve(std::max(count, 2 * map.size()));
+    }
+}
+}
+
+unsigned int Datastructures::add_affiliations_bulk(const std::vector<AffiliationRecord>& records)
+{
+    std::size_t count = affiliations.size() + records.size();
+    if(count > affiliations.xs.capacity()){
+        affiliations.reserve(std::max(count, 2 * affiliations.xs.capacity()));
+    }
+    grow_capacity(affiliations_vector, affiliations_vector.size() + records.size());
+    grow_capacity(affiliation_publication, affiliation_publication.size() + records.size());
+
+    std::vector<AffiliationHandle> added;
+    added.reserve(records.size());
+    for(const AffiliationRecord& record : records){
+        if(!affiliation_publication.try_emplace(record.id).second){
+            continue;
+        }
+        AffiliationHandle handle = affiliations.append(record.id, record.name, record.xy);
+        affiliations_vector.push_back(handle);
+        added.push_back(handle);
+    }
+
+    // The new handles are sorted in the order of each index, so that each
+    // can be inserted with the successor of the previous insert as the hint.
+    // That is amortized O(1) as long as no existing entry lies between
+    // consecutive new ones.
+    auto insert_sorted = [this, &added](auto& index){
+        std::vector<AffiliationHandle> sorted = added;
+        std::sort(sorted.begin(), sorted.end(), index.key_comp());
+        auto hint = index.begin();
+        for(AffiliationHandle handle : sorted){
+            hint = std::next(index.insert(hint, handle));
+        }
+    };
+    insert_sorted(affiliations_set);
+    insert_sorted(affiliations_distance);
+    insert_sorted(coord_to_affiliation);
+
+    std::vector<std::pair<AffiliationID, AffiliationHandle>> by_id;
+    by_id.reserve(added.size());
+    for(AffiliationHandle handle : added){
+        by_id.emplace_back(affiliations.id(handle), handle);
+    }
+    std::sort(by_id.begin(), by_id.end());
+    auto id_hint = affiliation_map.begin();
+    for(auto& entry : by_id){
+        id_hint = std::next(affiliation_map.insert(id_hint, std::move(entry)));
+    }
+    return added.size();
+}
+
+unsigned int Datastructures::add_publications_bulk(const std::vector<PublicationRecord>& records)
+{
+    grow_capacity(publications_vector, publications_vector.size() + records.size());
+
+    unsigned int added = 0;
+    for(const PublicationRecord& record : records){
+        auto [it, inserted] = publication_map.try_emplace(record.id);
+        if(!inserted){
+            continue;
+        }
+        Publication& publication = it->second;
+        publication.id = record.id;
+        publication.title = record.name;
+        publication.publication_year = record.year;
+        publication.parent = nullptr;
+        for(const AffiliationID& affiliation_id : record.affiliations){
+            publication.publication_affiliation.insert(affiliation_id);
+            affiliation_publication[affiliation_id].insert(record.id);
+        }
+        publications_vector.push_back(record.id);
+        ++added;
+    }
+    return added;
+}
+
+std::vector<Datastructures::AffiliationHandle> Datastructures::nearest(Coord xy, std::size_t k, long long max_square_distance)
+{
+    square_distances(xy);
+
+    std::vector<std::pair<long long, AffiliationHandle>> candidates;
+    for(AffiliationHandle handle = 0; handle < affiliations.size(); ++handle){
+        if(distance_scratch[handle] <= max_square_distance && affiliations.exists[handle]){
+            candidates.emplace_back(distance_scratch[handle], handle);
+        }
+    }
+
+    auto closer = [this](const std::pair<long long, AffiliationHandle>& a, const std::pair<long long, AffiliationHandle>& b){
+        if(a.first != b.first){
+            return a.first < b.first;
+        }
+        if(affiliations.ys[a.second] != affiliations.ys[b.second]){
+            return affiliations.ys[a.second] < affiliations.ys[b.second];
+        }
+        return affiliations.id(a.second) < affiliations.id(b.second);
+    };
+    if(k < candidates.size()){
+        std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), closer);
+        candidates.resize(k);
+    }
+    std::sort(candidates.begin(), candidates.end(), closer);
+
+    std::vector<AffiliationHandle> handles;
+    handles.reserve(candidates.size());
+    for(const auto& candidate : candidates){
+        handles.push_back(candidate.second);
+    }
+    return handles;
+}
+
+bool Datastructures::remove_affiliation(AffiliationID id)
+{
+    auto iter = affiliation_map.find(id);
+
+    if(iter == affiliation_map.end()){
+        return false;
+    }
+
+    AffiliationHandle handle = iter->second;
+    affiliation_map.erase(iter);
+
+    affiliation_publication.erase(id);
+
+    affiliations_vector.erase(std::remove(affiliations_vector.begin(),affiliations_vector.end(),handle),affiliations_vector.end());
+
+
+    for(const PublicationID& publication_id : publications_vector){
+        auto publication_iter = publication_map.find(publication_id);
+
+        if(publication_iter != publication_map.end()){
+            Publication& publication = publication_iter->second;
+
+            publication.publication_affiliation.erase(id);
+        }
+    }
+
+    affiliations_set.erase(handle);
+
+    affiliations_distance.erase(handle);
+
+    coord_to_affiliation.erase(handle);
+
+    affiliations.exists[handle] = 0;
+
+    return true;
+}
+
+PublicationID Datastructures::get_closest_common_parent(PublicationID id1, PublicationID id2)
+{
+    auto iter1 = publication_map.find(id1);
+    auto iter2 = publication_map.find(id2);
+
+    if(iter1 == publication_map.end()|| iter2 == publication_map.end()){
+        return NO_PUBLICATION;
+    }
+
+    std::vector<PublicationID> chain1 = get_referenced_by_chain(id1);
+    std::vector<PublicationID> chain2 = get_referenced_by_chain(id2);
+
+    PublicationID common_parent = find_closest_common_parent(chain1,chain2);
+
+    return common_parent;
+}
+
+bool Datastructures::remove_publication(PublicationID publicationid)
+{
+    auto iter = publication_map.find(publicationid);
+
+    if(iter == publication_map.end()){
+        return false;
+    }
+
+
+
+    const Publication& publication_toremove = iter->second;
+
+    for(auto&entry : publication_map){
+        auto& other_publication = entry.second;
+        if(other_publication.parent == &publication_toremove){
+            other_publication.parent = nullptr;
+        }
+    }
+
+    for(auto& affiliation_entry : affiliation_publication){
+        auto& publication_set = affiliation_entry.second;
+        publication_set.erase(publicationid);
+    }
+
+    publication_map.erase(publicationid);
+    publications_vector.erase(std::remove(publications_vector.begin(),publications_vector.end(),publicationid),publications_vector.end());
+
+    return true;
+}
+
+namespace
+{
+// Heap use of the standard containers as libstdc++ lays them out on a 64 bit
+// glibc system. Each allocation takes a malloc chunk: the request plus an 8
+// byte header rounded up to 16 bytes, 32 bytes at least. Tree nodes carry
+// colour and three links before the value, hash nodes a next pointer and
+// (assumed here) the cached hash code.
+std::size_t const TREE_NODE_LINKS = 32;
+std::size_t const HASH_NODE_LINKS = 2 * sizeof(void*);
+// Longest string kept inside the string object itself
+std::size_t const SHORT_STRING_CAPACITY = 15;
+
+void add_allocation(MemoryUsage& usage, std::size_t size)
+{
+    if (size > 0) {
+        usage.bytes += std::max<std::size_t>(32, (size + 8 + 15) / 16 * 16);
+        ++usage.allocations;
+    }
+}
+
+void add_string(MemoryUsage& usage, const std::string& text)
+{
+    if (text.capacity() > SHORT_STRING_CAPACITY) {
+        add_allocation(usage, text.capacity() + 1);
+    }
+}
+
+// Contents callback for elements that own no memory of their own
+struct NoContents {
+    template <typename Type>
+    void operator()(MemoryUsage&, const Type&) const {}
+};
+
+template <typename Type, typename Contents = NoContents>
+void add_vector(MemoryUsage& usage, const std::vector<Type>& values, Contents contents = {})
+{
+    usage.bytes += sizeof(values);
+    add_allocation(usage, values.capacity() * sizeof(Type));
+    for (const auto& value : values) {
+        contents(usage, value);
+    }
+}
+
+// std::set and std::map
+template <typename Tree, typename Contents = NoContents>
+void add_tree(MemoryUsage& usage, const Tree& tree, Contents contents = {})
+{
+    usage.bytes += sizeof(tree);
+    for (const auto& value : tree) {
+        add_allocation(usage, TREE_NODE_LINKS + sizeof(value));
+        contents(usage, value);
+    }
+}
+
+// std::unordered_set and std::unordered_map, a single bucket lives inside the object
+template <typename Table, typename Contents = NoContents>
+void add_hash_table(MemoryUsage& usage, const Table& table, Contents contents = {})
+{
+    usage.bytes += sizeof(table);
+    if (table.bucket_count() > 1) {
+        add_allocation(usage, table.bucket_count() * sizeof(void*));
+    }
+    for (const auto& value : table) {
+        add_allocation(usage, HASH_NODE_LINKS + sizeof(value));
+        contents(usage, value);
+    }
+}
+
+}
+
+std::vector<MemoryUsage> Datastructures::memory_usage()
+{
+    std::vector<MemoryUsage> rows;
+    auto row = [&rows](const char* container, std::size_t elements) -> MemoryUsage& {
+        rows.push_back({container, elements});
+        return rows.back();
+    };
+
+    MemoryUsage& table = row("affiliations", affiliations.size());
+    add_vector(table, affiliations.xs);
+    add_vector(table, affiliations.ys);
+    add_vector(table, affiliations.distances);
+    add_vector(table, affiliations.exists);
+    add_vector(table, affiliations.id_offsets);
+    add_vector(table, affiliations.id_chars);
+    add_vector(table, affiliations.name_offsets);
+    add_vector(table, affiliations.name_chars);
+    add_vector(row("affiliations_vector", affiliations_vector.size()), affiliations_vector);
+    add_vector(row("distance_scratch", distance_scratch.size()), distance_scratch);
+    add_tree(row("affiliations_set", affiliations_set.size()), affiliations_set);
+    add_tree(row("affiliations_distance", affiliations_distance.size()), affiliations_distance);
+    add_tree(row("affiliation_map", affiliation_map.size()), affiliation_map,
+             [](MemoryUsage& usage, const auto& entry) { add_string(usage, entry.first); });
+    add_tree(row("coord_to_affiliation", coord_to_affiliation.size()), coord_to_affiliation);
+    add_vector(row("publications_vector", publications_vector.size()), publications_vector);
+    add_tree(row("publication_map", publication_map.size()), publication_map, [](MemoryUsage& usage, const auto& entry) {
+        const Publication& publication = entry.second;
+        add_string(usage, publication.title);
+        add_tree(usage, publication.publication_affiliation, add_string);
+        add_tree(usage, publication.references);
+        // The sets themselves are inside the node already counted
+        usage.bytes -= sizeof(publication.publication_affiliation) + sizeof(publication.references);
+    });
+    add_hash_table(row("affiliation_publication", affiliation_publication.size()), affiliation_publication,
+                   [](MemoryUsage& usage, const auto& entry) {
+        add_string(usage, entry.first);
+        add_hash_table(usage, entry.second);
+        usage.bytes -= sizeof(entry.second);
+    });
+
+    return rows;
+}
@@ -1,310 +1,473 @@
-// Datastructures.hh
-
-
-
-#ifndef DATASTRUCTURES_HH
-#define DATASTRUCTURES_HH
-
-#include <string>
-#include <vector>
-#include <tuple>
-#include <utility>
-#include <limits>
-#include <functional>
-#include <exception>
-#include <set>
-#include <unordered_set>
-#include <map>
-#include <algorithm>
-#include <cmath>
-
-// Types for IDs
-using AffiliationID = std::string;
-using PublicationID = unsigned long long int;
-using Name = std::string;
-using Year = unsigned short int;
-using Weight = int;
-using Distance = int;
-
-// Return values for cases where required thing was not found
-AffiliationID const NO_AFFILIATION = "---";
-PublicationID const NO_PUBLICATION = -1;
-Name const NO_NAME = "!NO_NAME!";
-Year const NO_YEAR = -1;
-Weight const NO_WEIGHT = -1;
-
-// Return value for cases where integer values were not found
-int const NO_VALUE = std::numeric_limits<int>::min();
-
-// Type for a coordinate (x, y)
-struct Coord
-{
-    int x = NO_VALUE;
-    int y = NO_VALUE;
-};
-
-
-// Example: Defining == and hash function for Coord so that it can be used
-// as key for std::unordered_map/set, if needed
-inline bool operator==(Coord c1, Coord c2) { return c1.x == c2.x && c1.y == c2.y; }
-inline bool operator!=(Coord c1, Coord c2) { return !(c1==c2); } // Not strictly necessary
-
-struct CoordHash
-{
-    std::size_t operator()(Coord xy) const
-    {
-        auto hasher = std::hash<int>();
-        auto xhash = hasher(xy.x);
-        auto yhash = hasher(xy.y);
-        // Combine hash values (magic!)
-        return xhash ^ (yhash + 0x9e3779b9 + (xhash << 6) + (xhash >> 2));
-    }
-};
-
-// Example: Defining < for Coord so that it can be used
-// as key for std::map/set
-inline bool operator<(Coord c1, Coord c2)
-{
-    if (c1.y < c2.y) { return true; }
-    else if (c2.y < c1.y) { return false; }
-    else { return c1.x < c2.x; }
-}
-
-// Return value for cases where coordinates were not found
-Coord const NO_COORD = {NO_VALUE, NO_VALUE};
-
-// Return value for cases where Distance is unknown
-Distance const NO_DISTANCE = NO_VALUE;
-
-// This exception class is there just so that the user interface can notify
-// about operations which are not (yet) implemented
-class NotImplemented : public std::exception
-{
-public:
-    NotImplemented() : msg_{} {}
-    explicit NotImplemented(std::string const& msg) : msg_{msg + " not implemented"} {}
-
-    virtual const char* what() const noexcept override
-    {
-        return msg_.c_str();
-    }
-private:
-    std::string msg_;
-};
-
-// This is the class you are supposed to implement
-
-class Datastructures
-{
-public:
-    Datastructures();
-    ~Datastructures();
-
-    // Estimate of performance: O(1)
-    // Short rationale for estimate: One constant time operation which determines the size of the map
-    unsigned int get_affiliation_count();
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: The clear function is linear where n depends on the size of elements in a data structure
-    void clear_all();
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: Returning an affiliations vector
-    std::vector<AffiliationID> get_all_affiliations();
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Inserting into the datastructures has log N complexity.
-    bool add_affiliation(AffiliationID id, Name const& name, Coord xy);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding operation in a map has logarithmic time complexity.
-    Name get_affiliation_name(AffiliationID id);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding operation in a map has logarithmic time complexity.
-    Coord get_affiliation_coord(AffiliationID id);
-
-
-    // We recommend you implement the operations below only after implementing the ones above
-
-    // Estimate of performance: O(nlogn)
-    // Short rationale for estimate: The sorting and set creation is logn where n is the number of elements the elements inserted to vector.
-    std::vector<AffiliationID> get_affiliations_alphabetically();
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: The looping over the set and the insertion into the vector has linear complexity.
-    std::vector<AffiliationID> get_affiliations_distance_increasing();
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Accessing elements of an ordered map has logarithmic complexity.
-    AffiliationID find_affiliation_with_coord(Coord xy);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding an element in a map has logn time complexity.
-    bool change_affiliation_coord(AffiliationID id, Coord newcoord);
-
-
-    // We recommend you implement the operations below only after implementing the ones above
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: Finding an element in a map is logn time complexity.
-    bool add_publication(PublicationID id, Name const& name, Year year, const std::vector<AffiliationID> & affiliations);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: Copying elements to a vector is linear.
-    std::vector<PublicationID> all_publications();
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding an element in a map is logarithmic.
-    Name get_publication_name(PublicationID id);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding an element in a map is logarithmic.
-    Year get_publication_year(PublicationID id);
-
-    // Estimate of performance: O(nlogn)
-    // Short rationale for estimate: Finding an element in a map and copying to a vector.
-    std::vector<AffiliationID> get_affiliations(PublicationID id);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding an element in a map is logarithmic.
-    bool add_reference(PublicationID id, PublicationID parentid);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: Finding an element in a map is logarithmic.
-    std::vector<PublicationID> get_direct_references(PublicationID id);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate: Finding an element in a map is logarithmic.
-    bool add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate:Adding elements to a vector is linear.
-    std::vector<PublicationID> get_publications(AffiliationID id);
-
-    // Estimate of performance: O(logn)
-    // Short rationale for estimate:Finding an element in a map is logarithmic.
-    PublicationID get_parent(PublicationID id);
-
-    // Estimate of performance: O(nlogn)
-    // Short rationale for estimate:Finding an element in a map is logarithmic and there is also looping to add elemts to a vector.
-    std::vector<std::pair<Year, PublicationID>> get_publications_after(AffiliationID affiliationid, Year year);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: The depth of the chain is n and affects the performance.
-    std::vector<PublicationID> get_referenced_by_chain(PublicationID id);
-
-
-    // Non-compulsory operations
-
-    // Estimate of performance: O(B+E)
-    // Short rationale for estimate: As the function uses bfs search the time complexity is linear.
-    std::vector<PublicationID> get_all_references(PublicationID id);
-
-    // Estimate of performance: O(nlogn)
-    // Short rationale for estimate: Insertion into a set is logarithmic and insertion into a vector is linear.
-    std::vector<AffiliationID> get_affiliations_closest_to(Coord xy);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate: Erase operation has linear time complexity.
-    bool remove_affiliation(AffiliationID id);
-
-    // Estimate of performance: O(n)
-    // Short rationale for estimate:Linear because of the find common parent operation.
-    PublicationID get_closest_common_parent(PublicationID id1, PublicationID id2);
-
-    // Estimate of performance:O(n)
-    // Short rationale for estimate: Linear because of the iterations done.
-    bool remove_publication(PublicationID publicationid);
-
-
-private:
-    struct Affiliation{
-        AffiliationID id;
-        Name name;
-        Coord xy;
-    };
-
-    struct Publication{
-        PublicationID id;
-        std::string title;
-        Year publication_year;
-        Publication* parent;
-        std::set<AffiliationID> publication_affiliation;
-        std::set<Publication*> references;
-    };
-
-    struct DistanceComparator {
-        bool operator()(const Affiliation& a, const Affiliation& b) const {
-            auto distanceA = std::sqrt(a.xy.x * a.xy.x + a.xy.y * a.xy.y);
-            auto distanceB = std::sqrt(b.xy.x * b.xy.x + b.xy.y * b.xy.y);
-
-            if (distanceA != distanceB) {
-                return distanceA < distanceB;
-            }
-            else {
-                return a.xy.y < b.xy.y;
-            }
-        }
-    };
-
-    struct AffiliationNameComparator {
-        bool operator()(const Affiliation& a, const Affiliation& b) const {
-
-            return a.name < b.name;
-        }
-    };
-
-
-    struct AffiliationIDComparator {
-        bool operator()(const Affiliation& a, const Affiliation& b) const {
-            return a.id < b.id;
-        }
-    };
-
-    double calculate_distance(const Coord& coord1, const Coord& coord2){
-        double dx = coord1.x - coord2.x;
-        double dy = coord1.y - coord2.y;
-
-        double result = std::sqrt((dx*dx)+(dy*dy));
-
-        return result;
-    }
-
-
-
-    PublicationID find_closest_common_parent(const std::vector<PublicationID>& chain1, const std::vector<PublicationID>& chain2){
-
-        auto iter1 = chain1.rbegin();
-        auto iter2 = chain2.rbegin();
-
-        while(iter1!=chain1.rend() && iter2 != chain2.rend() && *iter1 == *iter2){
-            iter1++;
-            iter2++;
-        }
-
-        if(iter1 != chain1.rbegin()){
-            return *std::prev(iter1);
-        }
-        else if(iter2 != chain2.rbegin()){
-            return *std::prev(iter2);
-        }
-        else{
-            return NO_PUBLICATION;
-        }
-    }
-
-    std::vector<AffiliationID> affiliations_vector;
-    std::set<Affiliation,AffiliationNameComparator> affiliations_set;
-    std::set<Affiliation, DistanceComparator> affiliations_distance;
-    std::map<AffiliationID, Affiliation> affiliation_map;
-    std::vector<PublicationID> publications_vector;
-    std::map<PublicationID, Publication> publication_map;
-    std::map<Coord, AffiliationID> coord_to_affiliation;
-    std::unordered_map<AffiliationID, std::unordered_set<PublicationID>> affiliation_publication;
-
-
-
-};
-
-#endif // DATASTRUCTURES_HH
+// Datastructures.hh
+
+
+
+#ifndef DATASTRUCTURES_HH
+#define DATASTRUCTURES_HH
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <limits>
+#include <functional>
+#include <exception>
+#include <set>
+#include <unordered_set>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+// Types for IDs
+using AffiliationID = std::string;
+using PublicationID = unsigned long long int;
+using Name = std::string;
+using Year = unsigned short int;
+using Weight = int;
+using Distance = int;
+
+// Return values for cases where required thing was not found
+AffiliationID const NO_AFFILIATION = "---";
+PublicationID const NO_PUBLICATION = -1;
+Name const NO_NAME = "!NO_NAME!";
+Year const NO_YEAR = -1;
+Weight const NO_WEIGHT = -1;
+
+// Return value for cases where integer values were not found
+int const NO_VALUE = std::numeric_limits<int>::min();
+
+// Type for a coordinate (x, y)
+struct Coord
+{
+    int x = NO_VALUE;
+    int y = NO_VALUE;
+};
+
+
+// Example: Defining == and hash function for Coord so that it can be used
+// as key for std::unordered_map/set, if needed
+inline bool operator==(Coord c1, Coord c2) { return c1.x == c2.x && c1.y == c2.y; }
+inline bool operator!=(Coord c1, Coord c2) { return !(c1==c2); } // Not strictly necessary
+
+struct CoordHash
+{
+    std::size_t operator()(Coord xy) const
+    {
+        auto hasher = std::hash<int>();
+        auto xhash = hasher(xy.x);
+        auto yhash = hasher(xy.y);
+        // Combine hash values (magic!)
+        return xhash ^ (yhash + 0x9e3779b9 + (xhash << 6) + (xhash >> 2));
+    }
+};
+
+// Example: Defining < for Coord so that it can be used
+// as key for std::map/set
+inline bool operator<(Coord c1, Coord c2)
+{
+    if (c1.y < c2.y) { return true; }
+    else if (c2.y < c1.y) { return false; }
+    else { return c1.x < c2.x; }
+}
+
+// Return value for cases where coordinates were not found
+Coord const NO_COORD = {NO_VALUE, NO_VALUE};
+
+// Return value for cases where Distance is unknown
+Distance const NO_DISTANCE = NO_VALUE;
+
+// Input records for the bulk add operations, one per add_affiliation or
+// add_publication call they replace
+struct AffiliationRecord {
+    AffiliationID id;
+    Name name;
+    Coord xy;
+};
+
+struct PublicationRecord {
+    PublicationID id;
+    Name name;
+    Year year;
+    std::vector<AffiliationID> affiliations;
+};
+
+// One row of memory_usage: the estimated heap footprint of a member container
+struct MemoryUsage {
+    std::string container;
+    std::size_t elements = 0;
+    std::size_t bytes = 0; // including the container object itself
+    std::size_t allocations = 0;
+};
+
+// This exception class is there just so that the user interface can notify
+// about operations which are not (yet) implemented
+class NotImplemented : public std::exception
+{
+public:
+    NotImplemented() : msg_{} {}
+    explicit NotImplemented(std::string const& msg) : msg_{msg + " not implemented"} {}
+
+    virtual const char* what() const noexcept override
+    {
+        return msg_.c_str();
+    }
+private:
+    std::string msg_;
+};
+
+// This is the class you are supposed to implement
+
+class Datastructures
+{
+public:
+    Datastructures();
+    ~Datastructures();
+    // The ordered sets refer back to the affiliation table of their own object
+    Datastructures(const Datastructures&) = delete;
+    Datastructures& operator=(const Datastructures&) = delete;
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: One constant time operation which determines the size of the map
+    unsigned int get_affiliation_count();
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: The clear function is linear where n depends on the size of elements in a data structure
+    void clear_all();
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Returning an affiliations vector
+    std::vector<AffiliationID> get_all_affiliations();
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Inserting into the datastructures has log N complexity.
+    bool add_affiliation(AffiliationID id, Name const& name, Coord xy);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding operation in a map has logarithmic time complexity.
+    Name get_affiliation_name(AffiliationID id);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding operation in a map has logarithmic time complexity.
+    Coord get_affiliation_coord(AffiliationID id);
+
+
+    // We recommend you implement the operations below only after implementing the ones above
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: The set is kept in order, the ids are copied out in one pass.
+    std::vector<AffiliationID> get_affiliations_alphabetically();
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: The looping over the set and the insertion into the vector has linear complexity.
+    std::vector<AffiliationID> get_affiliations_distance_increasing();
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Accessing elements of an ordered map has logarithmic complexity.
+    AffiliationID find_affiliation_with_coord(Coord xy);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding an element in a map has logn time complexity.
+    bool change_affiliation_coord(AffiliationID id, Coord newcoord);
+
+
+    // We recommend you implement the operations below only after implementing the ones above
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Finding an element in a map is logn time complexity.
+    bool add_publication(PublicationID id, Name const& name, Year year, const std::vector<AffiliationID> & affiliations);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Copying elements to a vector is linear.
+    std::vector<PublicationID> all_publications();
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding an element in a map is logarithmic.
+    Name get_publication_name(PublicationID id);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding an element in a map is logarithmic.
+    Year get_publication_year(PublicationID id);
+
+    // Estimate of performance: O(nlogn)
+    // Short rationale for estimate: Finding an element in a map and copying to a vector.
+    std::vector<AffiliationID> get_affiliations(PublicationID id);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding an element in a map is logarithmic.
+    bool add_reference(PublicationID id, PublicationID parentid);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Finding an element in a map is logarithmic.
+    std::vector<PublicationID> get_direct_references(PublicationID id);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate: Finding an element in a map is logarithmic.
+    bool add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate:Adding elements to a vector is linear.
+    std::vector<PublicationID> get_publications(AffiliationID id);
+
+    // Estimate of performance: O(logn)
+    // Short rationale for estimate:Finding an element in a map is logarithmic.
+    PublicationID get_parent(PublicationID id);
+
+    // Estimate of performance: O(nlogn)
+    // Short rationale for estimate:Finding an element in a map is logarithmic and there is also looping to add elemts to a vector.
+    std::vector<std::pair<Year, PublicationID>> get_publications_after(AffiliationID affiliationid, Year year);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: The depth of the chain is n and affects the performance.
+    std::vector<PublicationID> get_referenced_by_chain(PublicationID id);
+
+
+    // Non-compulsory operations
+
+    // Estimate of performance: O(B+E)
+    // Short rationale for estimate: As the function uses bfs search the time complexity is linear.
+    std::vector<PublicationID> get_all_references(PublicationID id);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: One vectorized pass over the coordinate columns and a partial selection of three.
+    std::vector<AffiliationID> get_affiliations_closest_to(Coord xy);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Erase operation has linear time complexity.
+    bool remove_affiliation(AffiliationID id);
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate:Linear because of the find common parent operation.
+    PublicationID get_closest_common_parent(PublicationID id1, PublicationID id2);
+
+    // Estimate of performance:O(n)
+    // Short rationale for estimate: Linear because of the iterations done.
+    bool remove_publication(PublicationID publicationid);
+
+    // Estimate of performance: O(n + p)
+    // Short rationale for estimate: Every element is visited once to add up the strings and sets it owns.
+    // Estimated heap use of each member, computed from sizes and capacities
+    // as libstdc++ and glibc malloc would lay them out.
+    std::vector<MemoryUsage> memory_usage();
+
+    // Estimate of performance: O(n + k log k)
+    // Short rationale for estimate: One vectorized pass over the coordinate columns, then a partial selection.
+    // The k affiliations closest to xy, ordered by distance, then y
+    // coordinate, then id.
+    std::vector<AffiliationID> get_affiliations_closest_to_k(Coord xy, unsigned int k);
+
+    // Estimate of performance: O(n + m log m), m = affiliations within the radius
+    // Short rationale for estimate: One vectorized pass over the coordinate columns, then the matches are sorted.
+    // Affiliations at most radius away from xy, in the same order as
+    // get_affiliations_closest_to_k.
+    std::vector<AffiliationID> get_affiliations_within_radius(Coord xy, int radius);
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: A CPU feature check.
+    // Selects the distance kernel of the nearest affiliation queries: "avx2",
+    // "sse2", "scalar", or "auto" for the widest one the CPU supports.
+    // Returns the kernel in use, or an empty string if the requested one
+    // isn't available.
+    std::string set_distance_kernel(std::string const& name);
+
+    // Estimate of performance: O((r + 1) log n + k), r = rows of the rectangle that have affiliations
+    // Short rationale for estimate: The coordinate set is ordered row by row, each row is found with one lookup.
+    // Affiliations with min.x <= x <= max.x and min.y <= y <= max.y, ordered
+    // by y coordinate, then x coordinate, then id.
+    std::vector<AffiliationID> get_affiliations_in_rect(Coord min, Coord max);
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: The box is extended whenever a coordinate is set
+    // {min, max} of a rectangle containing every existing affiliation, or
+    // {NO_COORD, NO_COORD} if there are none. It doesn't shrink when
+    // affiliations move or are removed, only on clear_all.
+    std::pair<Coord, Coord> get_affiliation_extent();
+
+    // Estimate of performance: O(k log k + k log n) worst case, O(k log k + n) when the new entries
+    // don't interleave with the existing ones, k = number of records
+    // Short rationale for estimate: Capacity is reserved once, sorted new entries are inserted next to each other
+    // Same result as calling add_affiliation for each record in order,
+    // returns the number of affiliations added
+    unsigned int add_affiliations_bulk(std::vector<AffiliationRecord> const& records);
+
+    // Estimate of performance: O(k (log n + a log a)), a = affiliations per record
+    // Short rationale for estimate: One map search per record, each publication is built in place in the map rather than copied into it
+    // Same result as calling add_publication for each record in order,
+    // returns the number of publications added
+    unsigned int add_publications_bulk(std::vector<PublicationRecord> const& records);
+
+
+private:
+    using AffiliationHandle = std::uint32_t;
+
+    // Bounding box that only grows, empty until the first coordinate
+    struct CoordBox{
+        Coord min = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+        Coord max = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+        void extend(Coord coord){
+            min = {std::min(min.x, coord.x), std::min(min.y, coord.y)};
+            max = {std::max(max.x, coord.x), std::max(max.y, coord.y)};
+        }
+        bool empty() const { return min.x > max.x; }
+    };
+
+    // Affiliations stored column by column, a handle being the position of
+    // an affiliation in the columns. Ids and names are kept in character
+    // arenas, the text of handle h being chars[offsets[h], offsets[h+1]).
+    // Removed affiliations leave their slots behind.
+    struct AffiliationTable{
+        std::vector<int> xs;
+        std::vector<int> ys;
+        std::vector<long long> distances; // squared distance from (0,0)
+        std::vector<std::uint8_t> exists;
+        std::vector<std::uint64_t> id_offsets = {0};
+        std::vector<char> id_chars;
+        std::vector<std::uint64_t> name_offsets = {0};
+        std::vector<char> name_chars;
+        CoordBox extent; // of every coordinate set since the table was cleared
+
+        std::size_t size() const { return xs.size(); }
+        Coord xy(AffiliationHandle handle) const { return {xs[handle], ys[handle]}; }
+        std::string_view id(AffiliationHandle handle) const {
+            return {id_chars.data() + id_offsets[handle], id_offsets[handle + 1] - id_offsets[handle]};
+        }
+        std::string_view name(AffiliationHandle handle) const {
+            return {name_chars.data() + name_offsets[handle], name_offsets[handle + 1] - name_offsets[handle]};
+        }
+        AffiliationHandle append(const AffiliationID& id, const Name& name, Coord coord){
+            id_chars.insert(id_chars.end(), id.begin(), id.end());
+            id_offsets.push_back(id_chars.size());
+            name_chars.insert(name_chars.end(), name.begin(), name.end());
+            name_offsets.push_back(name_chars.size());
+            xs.push_back(0);
+            ys.push_back(0);
+            distances.push_back(0);
+            exists.push_back(1);
+            AffiliationHandle handle = static_cast<AffiliationHandle>(xs.size() - 1);
+            set_xy(handle, coord);
+            return handle;
+        }
+        void set_xy(AffiliationHandle handle, Coord coord){
+            xs[handle] = coord.x;
+            ys[handle] = coord.y;
+            distances[handle] = static_cast<long long>(coord.x) * coord.x + static_cast<long long>(coord.y) * coord.y;
+            extent.extend(coord);
+        }
+        void reserve(std::size_t count){
+            xs.reserve(count);
+            ys.reserve(count);
+            distances.reserve(count);
+            exists.reserve(count);
+            id_offsets.reserve(count + 1);
+            name_offsets.reserve(count + 1);
+        }
+        void clear(){
+            *this = AffiliationTable();
+        }
+    };
+
+    struct Publication{
+        PublicationID id;
+        std::string title;
+        Year publication_year;
+        Publication* parent;
+        std::set<AffiliationID> publication_affiliation;
+        std::set<Publication*> references;
+    };
+
+    // The comparators order handles by the table columns. Ties are broken
+    // by handle so that affiliations with equal keys are all kept.
+    struct DistanceComparator {
+        const AffiliationTable* table;
+        bool operator()(AffiliationHandle a, AffiliationHandle b) const {
+            if (table->distances[a] != table->distances[b]) {
+                return table->distances[a] < table->distances[b];
+            }
+            else if (table->ys[a] != table->ys[b]) {
+                return table->ys[a] < table->ys[b];
+            }
+            else {
+                return a < b;
+            }
+        }
+    };
+
+    // Orders handles by coordinate as Coord's operator< does (y, then x),
+    // then by id, so that affiliations sharing a coordinate are all kept.
+    // Transparent so that the set can be searched with a Coord.
+    struct CoordComparator {
+        using is_transparent = void;
+        const AffiliationTable* table;
+        bool operator()(AffiliationHandle a, AffiliationHandle b) const {
+            Coord first = table->xy(a);
+            Coord second = table->xy(b);
+            if (first < second || second < first) {
+                return first < second;
+            }
+            return table->id(a) < table->id(b);
+        }
+        bool operator()(AffiliationHandle a, Coord b) const {
+            return table->xy(a) < b;
+        }
+        bool operator()(Coord a, AffiliationHandle b) const {
+            return a < table->xy(b);
+        }
+    };
+
+    struct AffiliationNameComparator {
+        const AffiliationTable* table;
+        bool operator()(AffiliationHandle a, AffiliationHandle b) const {
+            int order = table->name(a).compare(table->name(b));
+            return order != 0 ? order < 0 : a < b;
+        }
+    };
+
+    // Squared distances of all slots to one point, computed in a single pass
+    // by the widest kernel the CPU supports unless set_distance_kernel says
+    // otherwise.
+    enum class DistanceKernel { SCALAR, SSE2, AVX2 };
+    DistanceKernel distance_kernel = DistanceKernel::SCALAR;
+    std::vector<long long> distance_scratch;
+    void square_distances(Coord xy);
+
+    // At most k affiliations closest to xy whose squared distance is at most
+    // max_square_distance, ordered by distance, then y coordinate, then id.
+    std::vector<AffiliationHandle> nearest(Coord xy, std::size_t k, long long max_square_distance);
+
+    PublicationID find_closest_common_parent(const std::vector<PublicationID>& chain1, const std::vector<PublicationID>& chain2){
+
+        auto iter1 = chain1.rbegin();
+        auto iter2 = chain2.rbegin();
+
+        while(iter1!=chain1.rend() && iter2 != chain2.rend() && *iter1 == *iter2){
+            iter1++;
+            iter2++;
+        }
+
+        if(iter1 != chain1.rbegin()){
+            return *std::prev(iter1);
+        }
+        else if(iter2 != chain2.rbegin()){
+            return *std::prev(iter2);
+        }
+        else{
+            return NO_PUBLICATION;
+        }
+    }
+
+    AffiliationTable affiliations;
+    std::vector<AffiliationHandle> affiliations_vector;
+    std::set<AffiliationHandle, AffiliationNameComparator> affiliations_set{AffiliationNameComparator{&affiliations}};
+    std::set<AffiliationHandle, DistanceComparator> affiliations_distance{DistanceComparator{&affiliations}};
+    std::map<AffiliationID, AffiliationHandle> affiliation_map;
+    std::vector<PublicationID> publications_vector;
+    std::map<PublicationID, Publication> publication_map;
+    std::set<AffiliationHandle, CoordComparator> coord_to_affiliation{CoordComparator{&affiliations}};
+    std::unordered_map<AffiliationID, std::unordered_set<PublicationID>> affiliation_publication;
+
+
+
+};
+
+#endif // DATASTRUCTURES_HH
@@ -1,435 +1,519 @@
-// The main program (provided by the course), COMP.CS.300
-//
-// DO ****NOT**** EDIT THIS FILE!
-// (Preferably do not edit this even temporarily. And if you still decide to do so
-//  (for debugging, for example), DO NOT commit any changes to git, but revert all
-//  changes later. Otherwise you won't be able to get any updates/fixes to this
-//  file from git!)
-#ifndef MAINPROGRAM_HH
-#define MAINPROGRAM_HH
-
-
-#ifdef QT_CORE_LIB
-#ifndef NO_GRAPHICAL_GUI
-#define GRAPHICAL_GUI
-#endif
-#endif
-
-
-#include <string>
-#include <random>
-#include <regex>
-#include <chrono>
-#include <sstream>
-#include <stdexcept>
-#include <iostream>
-#include <vector>
-#include <array>
-#include <functional>
-#include <utility>
-#include <variant>
-#include <bitset>
-#include <cassert>
-#include <cstring>
-#include <unordered_set>
-
-#include "datastructures.hh"
-
-// default max and min values for perftesting and random add, may be subject to change
-
-const Coord RANDOM_MIN_COORD = {0,0};
-const Coord RANDOM_MAX_COORD = {10000,10000};
-const Year RANDOM_MIN_YEAR = 0;
-const Year RANDOM_MAX_YEAR = 9998;
-
-const double ROOT_BIAS_MULTIPLIER = 0.05;
-const double LEAF_BIAS_MULTIPLIER = 0.5;
-
-class MainWindow; // In case there's UI
-
-class MainProgram
-{
-public:
-    MainProgram();
-
-
-    class Stopwatch;
-
-    enum class PromptStyle { NORMAL, NO_ECHO, NO_NESTING };
-    enum class TestStatus { NOT_RUN, NO_DIFFS, DIFFS_FOUND };
-
-    bool command_parse_line(std::string input, std::ostream& output);
-    void command_parser(std::istream& input, std::ostream& output, PromptStyle promptstyle);
-
-    void setui(MainWindow* ui);
-
-    void flush_output(std::ostream& output);
-    bool check_stop() const;
-
-    static int mainprogram(int argc, char* argv[]);
-
-private:
-    Datastructures ds_;
-    MainWindow* ui_ = nullptr;
-
-    static std::string const PROMPT;
-
-    std::minstd_rand rand_engine_;
-
-    static std::array<unsigned long int, 20> const primes1;
-    static std::array<unsigned long int, 20> const primes2;
-    unsigned long int prime1_ = 0; // Will be initialized to random value from above
-    unsigned long int prime2_ = 0; // Will be initialized to random value from above
-    unsigned long int random_affiliations_added_ = 0; // Counter for random affiliations added
-    unsigned long int random_publications_added_ = 0; // Counter for random publications added
-    void init_primes();
-    Name n_to_name(unsigned long int n);
-    AffiliationID n_to_affiliationid(unsigned long int n);
-    PublicationID n_to_publicationid(unsigned long int n);
-    Coord n_to_coord(unsigned long int n);
-
-
-    enum class StopwatchMode { OFF, ON, NEXT };
-    StopwatchMode stopwatch_mode = StopwatchMode::OFF;
-
-    enum class ResultType { NOTHING, IDLIST};
-    using CmdResultIDs = std::pair<std::vector<PublicationID>, std::vector<AffiliationID>>;
-
-    using CmdResult = std::pair<ResultType, std::variant<CmdResultIDs>>;
-    CmdResult prev_result;
-    bool view_dirty = true;
-
-    TestStatus test_status_ = TestStatus::NOT_RUN;
-
-    using MatchIter = std::smatch::const_iterator;
-    struct CmdInfo
-    {
-        std::string cmd;
-        std::string info;
-        std::string param_regex_str;
-        CmdResult(MainProgram::*func)(std::ostream& output, MatchIter begin, MatchIter end);
-        void(MainProgram::*testfunc)();
-        std::regex param_regex = {};
-    };
-    static std::vector<CmdInfo> cmds_;
-    // Regex objects and their initialization
-    std::regex cmds_regex_;
-    std::regex coords_regex_;
-    std::regex affil_regex_;
-    std::regex times_regex_;
-    std::regex commands_regex_;
-    std::regex sizes_regex_;
-    void init_regexs();
-
-
-    CmdResult cmd_get_affiliation_count(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_clear_all(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_all_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_add_affiliation(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_affiliation_info(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_find_affiliation_with_coord(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_change_affiliation_coord(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_publications_after(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_add_publication(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_all_publications(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_publication_info(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_add_reference(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_add_affiliation_to_publication(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_publications(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_all_references(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_affiliations_closest_to(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_remove_affiliation(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_closest_common_parent(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_remove_publication(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_parent(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_referenced_by_chain(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_direct_references(std::ostream& output, MatchIter begin, MatchIter end);
-
-    CmdResult help_command(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_randseed(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_random_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_read(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_testread(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_stopwatch(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_perftest(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_comment(std::ostream& output, MatchIter begin, MatchIter end);
-    CmdResult cmd_get_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
-
-    // random ids for perftest
-    AffiliationID random_affiliation();
-    PublicationID random_publication();
-
-    // biased random ids for some perftest
-    PublicationID random_root_publication();
-    PublicationID random_leaf_publication();
-
-    void test_get_functions(AffiliationID id);
-    void test_affiliation_info();
-    void test_find_affiliation_with_coord();
-    void test_change_affiliation_coord();
-    void test_get_publications_after();
-    void test_publication_info();
-    void test_get_publications();
-    void test_get_all_references();
-    void test_affiliations_closest_to();
-    void test_remove_affiliation();
-    void test_get_closest_common_parent();
-    void test_random_affiliations();
-    void test_remove_publication();
-    void test_get_parent();
-    void test_get_referenced_by_chain();
-    void test_get_direct_references();
-    void test_get_affiliations();
-    void test_get_affiliation_count();
-    void test_get_all_publications();
-    void test_add_affiliation_to_publication();
-
-
-    inline Coord get_random_coords(const Coord min = RANDOM_MIN_COORD, const Coord max = RANDOM_MAX_COORD);
-    inline Year get_random_year(const Year min = RANDOM_MIN_YEAR, const Year max = RANDOM_MAX_YEAR);
-    std::vector<Coord> get_unique_coords(const unsigned int n,const std::unordered_set<Coord,CoordHash>& exclude_list,const Coord min=RANDOM_MIN_COORD,const Coord max=RANDOM_MAX_COORD);
-    void add_random_affiliations_publications(unsigned int size, Coord min = RANDOM_MIN_COORD, Coord max = RANDOM_MAX_COORD,const std::vector<Coord>& coordinates={});
-    Distance calc_distance(Coord c1, Coord c2);
-    std::string print_affiliation(AffiliationID id, std::ostream& output, bool nl = true);
-    std::string print_affiliation_brief(AffiliationID id, std::ostream& output, bool nl = true);
-    std::string print_publication(PublicationID id, std::ostream& output, bool nl = true);
-    std::string print_affiliation_name(AffiliationID id, std::ostream& output, bool nl = true);
-    std::string print_coord(Coord coord, std::ostream& output, bool nl = true);
-
-    template <typename Type>
-    Type random(Type start, Type end);
-    template <typename To>
-    static To convert_string_to(std::string from);
-    template <typename From>
-    static std::string convert_to_string(From from);
-
-    template<AffiliationID(Datastructures::*MFUNC)()>
-    CmdResult NoParAffiliationCmd(std::ostream& output, MatchIter begin, MatchIter end);
-
-    template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
-    CmdResult NoParListCmd(std::ostream& output, MatchIter begin, MatchIter end);
-
-    template<AffiliationID(Datastructures::*MFUNC)()>
-    void NoParAffiliationTestCmd();
-
-    template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
-    void NoParListTestCmd();
-
-    friend class MainWindow;
-};
-
-template <typename Type>
-Type MainProgram::random(Type start, Type end)
-{
-    auto range = end-start;
-    assert(range != 0 && "random() with zero range!");
-
-    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine_);
-
-    return static_cast<Type>(start+num);
-}
-
-template <typename To>
-To MainProgram::convert_string_to(std::string from)
-{
-    std::istringstream istr(from);
-    To result;
-    istr >> std::noskipws >> result;
-    if (istr.fail() || !istr.eof())
-    {
-        throw std::invalid_argument("Cannot convert string to required type");
-    }
-    return result;
-}
-
-template <typename From>
-std::string MainProgram::convert_to_string(From from)
-{
-    std::ostringstream ostr;
-    ostr << from;
-    if (ostr.fail())
-    {
-        throw std::invalid_argument("Cannot convert type to string");
-    }
-    return ostr.str();
-}
-
-template<AffiliationID(Datastructures::*MFUNC)()>
-MainProgram::CmdResult MainProgram::NoParAffiliationCmd(std::ostream& /*output*/, MatchIter /*begin*/, MatchIter /*end*/)
-{
-    auto result = (ds_.*MFUNC)();
-    return {ResultType::IDLIST, CmdResultIDs{{}, {result}}};
-}
-
-template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
-MainProgram::CmdResult MainProgram::NoParListCmd(std::ostream& /*output*/, MatchIter /*begin*/, MatchIter /*end*/)
-{
-    auto result = (ds_.*MFUNC)();
-    return {ResultType::IDLIST, CmdResultIDs{{}, result}};
-}
-
-template<AffiliationID(Datastructures::*MFUNC)()>
-void MainProgram::NoParAffiliationTestCmd()
-{
-    (ds_.*MFUNC)();
-}
-
-template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
-void MainProgram::NoParListTestCmd()
-{
-    (ds_.*MFUNC)();
-}
-
-
-#ifdef USE_PERF_EVENT
-extern "C"
-{
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/perf_event.h>
-#include <asm/unistd.h>
-
-static long
-perf_event_open(struct perf_event_attr *hw_event, pid_t pid,
-                int cpu, int group_fd, unsigned long flags)
-{
-    int ret;
-
-    ret = syscall(__NR_perf_event_open, hw_event, pid, cpu,
-                  group_fd, flags);
-    return ret;
-}
-}
-#endif
-
-class MainProgram::Stopwatch
-{
-public:
-    using Clock = std::chrono::high_resolution_clock;
-
-    Stopwatch(bool use_counter = false) : use_counter_(use_counter)
-    {
-#ifdef USE_PERF_EVENT
-        if (use_counter_)
-        {
-            memset(&pe_, 0, sizeof(pe_));
-            pe_.type = PERF_TYPE_HARDWARE;
-            pe_.size = sizeof(pe_);
-            pe_.config = PERF_COUNT_HW_INSTRUCTIONS;
-            pe_.disabled = 1;
-            pe_.exclude_kernel = 1;
-            pe_.exclude_hv = 1;
-
-            fd_ = perf_event_open(&pe_, 0, -1, -1, 0);
-            if (fd_ == -1) {
-                throw "Couldn't open perf events!";
-            }
-        }
-#endif
-        reset();
-    }
-
-    ~Stopwatch()
-    {
-#ifdef USE_PERF_EVENT
-        if (use_counter_)
-        {
-            close(fd_);
-        }
-#endif
-    }
-
-    void start()
-    {
-        running_ = true;
-        starttime_ = Clock::now();
-#ifdef USE_PERF_EVENT
-        if (use_counter_)
-        {
-            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
-            read(fd_, &startcount_, sizeof(startcount_));
-            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
-        }
-#endif
-    }
-
-    void stop()
-    {
-        running_ = false;
-#ifdef USE_PERF_EVENT
-        if (use_counter_)
-        {
-            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
-            long long c; read(fd_, &c, sizeof(c));
-            counter_ += (c - startcount_);
-        }
-#endif
-        elapsed_ += (Clock::now() - starttime_);
-    }
-
-    void reset()
-    {
-        running_ = false;
-#ifdef USE_PERF_EVENT
-        if (use_counter_)
-        {
-            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
-            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
-            counter_ = 0;
-        }
-#endif
-        elapsed_ = elapsed_.zero();
-    }
-
-    double elapsed()
-    {
-        if (!running_)
-        {
-            return static_cast<std::chrono::duration<double>>(elapsed_).count();
-        }
-        else
-        {
-            auto total = elapsed_ + (Clock::now() - starttime_);
-            return static_cast<std::chrono::duration<double>>(total).count();
-        }
-    }
-
-#ifdef USE_PERF_EVENT
-    long long count()
-    {
-        if (use_counter_)
-        {
-            if (!running_)
-            {
-                return counter_;
-            }
-            else
-            {
-                long long c;
-                read(fd_, &c, sizeof(c));
-                return counter_ + (c - startcount_);
-            }
-        }
-        else
-        {
-            assert(!"perf_event not enabled during StopWatch creation!");
-        }
-    }
-#endif
-
-private:
-    std::chrono::time_point<Clock> starttime_;
-    Clock::duration elapsed_ = Clock::duration::zero();
-    bool running_ = false;
-
-    bool use_counter_;
-#ifdef USE_PERF_EVENT
-    struct perf_event_attr pe_;
-    long long startcount_ = 0;
-    long long counter_ = 0;
-    int fd_ = 0;
-#endif
-};
-
-
-#endif // MAINPROGRAM_HH
+// The main program (provided by the course), COMP.CS.300
+//
+// DO ****NOT**** EDIT THIS FILE!
+// (Preferably do not edit this even temporarily. And if you still decide to do so
+//  (for debugging, for example), DO NOT commit any changes to git, but revert all
+//  changes later. Otherwise you won't be able to get any updates/fixes to this
+//  file from git!)
+#ifndef MAINPROGRAM_HH
+#define MAINPROGRAM_HH
+
+
+#ifdef QT_CORE_LIB
+#ifndef NO_GRAPHICAL_GUI
+#define GRAPHICAL_GUI
+#endif
+#endif
+
+
+#include <string>
+#include <random>
+#include <regex>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <functional>
+#include <utility>
+#include <variant>
+#include <bitset>
+#include <cassert>
+#include <cstring>
+#include <unordered_set>
+
+#include "datastructures.hh"
+
+// default max and min values for perftesting and random add, may be subject to change
+
+const Coord RANDOM_MIN_COORD = {0,0};
+const Coord RANDOM_MAX_COORD = {10000,10000};
+const Year RANDOM_MIN_YEAR = 0;
+const Year RANDOM_MAX_YEAR = 9998;
+
+const double ROOT_BIAS_MULTIPLIER = 0.05;
+const double LEAF_BIAS_MULTIPLIER = 0.5;
+
+class MainWindow; // In case there's UI
+
+class MainProgram
+{
+public:
+    MainProgram();
+
+
+    class Stopwatch;
+
+    enum class PromptStyle { NORMAL, NO_ECHO, NO_NESTING };
+    enum class TestStatus { NOT_RUN, NO_DIFFS, DIFFS_FOUND };
+
+    bool command_parse_line(std::string input, std::ostream& output);
+    void command_parser(std::istream& input, std::ostream& output, PromptStyle promptstyle);
+
+    void setui(MainWindow* ui);
+
+    void flush_output(std::ostream& output);
+    bool check_stop() const;
+
+    static int mainprogram(int argc, char* argv[]);
+
+private:
+    Datastructures ds_;
+    MainWindow* ui_ = nullptr;
+
+    static std::string const PROMPT;
+
+    std::minstd_rand rand_engine_;
+
+    static std::array<unsigned long int, 20> const primes1;
+    static std::array<unsigned long int, 20> const primes2;
+    unsigned long int prime1_ = 0; // Will be initialized to random value from above
+    unsigned long int prime2_ = 0; // Will be initialized to random value from above
+    unsigned long int random_affiliations_added_ = 0; // Counter for random affiliations added
+    unsigned long int random_publications_added_ = 0; // Counter for random publications added
+    void init_primes();
+    Name n_to_name(unsigned long int n);
+    AffiliationID n_to_affiliationid(unsigned long int n);
+    PublicationID n_to_publicationid(unsigned long int n);
+    Coord n_to_coord(unsigned long int n);
+
+
+    enum class StopwatchMode { OFF, ON, NEXT };
+    StopwatchMode stopwatch_mode = StopwatchMode::OFF;
+
+    // Hardware counters read by stopwatch and perftest, chosen with the
+    // counters command
+    enum class HwCounter { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES };
+    static std::vector<std::pair<std::string, HwCounter>> const hw_counters_;
+    static std::string counter_name(HwCounter counter);
+    std::vector<HwCounter> counters_;
+
+    enum class ResultType { NOTHING, IDLIST};
+    using CmdResultIDs = std::pair<std::vector<PublicationID>, std::vector<AffiliationID>>;
+
+    using CmdResult = std::pair<ResultType, std::variant<CmdResultIDs>>;
+    CmdResult prev_result;
+    bool view_dirty = true;
+
+    TestStatus test_status_ = TestStatus::NOT_RUN;
+
+    using MatchIter = std::smatch::const_iterator;
+    struct CmdInfo
+    {
+        std::string cmd;
+        std::string info;
+        std::string param_regex_str;
+        CmdResult(MainProgram::*func)(std::ostream& output, MatchIter begin, MatchIter end);
+        void(MainProgram::*testfunc)();
+        std::regex param_regex = {};
+    };
+    static std::vector<CmdInfo> cmds_;
+    // Regex objects and their initialization
+    std::regex cmds_regex_;
+    std::regex coords_regex_;
+    std::regex affil_regex_;
+    std::regex times_regex_;
+    std::regex commands_regex_;
+    std::regex sizes_regex_;
+    void init_regexs();
+
+
+    CmdResult cmd_get_affiliation_count(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_clear_all(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_all_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_add_affiliation(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_affiliation_info(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_find_affiliation_with_coord(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_change_affiliation_coord(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_publications_after(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_add_publication(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_all_publications(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_publication_info(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_add_reference(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_add_affiliation_to_publication(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_publications(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_all_references(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_affiliations_closest_to(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_affiliations_closest_to_k(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_affiliations_within_radius(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_affiliations_in_rect(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_remove_affiliation(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_closest_common_parent(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_remove_publication(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_parent(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_referenced_by_chain(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_direct_references(std::ostream& output, MatchIter begin, MatchIter end);
+
+    CmdResult help_command(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_randseed(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_random_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_read(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_testread(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_memory_report(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_stopwatch(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_counters(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_distance_kernel(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_perftest(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_comment(std::ostream& output, MatchIter begin, MatchIter end);
+    CmdResult cmd_get_affiliations(std::ostream& output, MatchIter begin, MatchIter end);
+
+    // random ids for perftest
+    AffiliationID random_affiliation();
+    PublicationID random_publication();
+
+    // biased random ids for some perftest
+    PublicationID random_root_publication();
+    PublicationID random_leaf_publication();
+
+    void test_get_functions(AffiliationID id);
+    void test_affiliation_info();
+    void test_find_affiliation_with_coord();
+    void test_change_affiliation_coord();
+    void test_get_publications_after();
+    void test_publication_info();
+    void test_get_publications();
+    void test_get_all_references();
+    void test_affiliations_closest_to();
+    void test_affiliations_closest_to_k();
+    void test_affiliations_within_radius();
+    void test_affiliations_in_rect();
+    void test_remove_affiliation();
+    void test_get_closest_common_parent();
+    void test_random_affiliations();
+    void test_remove_publication();
+    void test_get_parent();
+    void test_get_referenced_by_chain();
+    void test_get_direct_references();
+    void test_get_affiliations();
+    void test_get_affiliation_count();
+    void test_get_all_publications();
+    void test_add_affiliation_to_publication();
+
+
+    inline Coord get_random_coords(const Coord min = RANDOM_MIN_COORD, const Coord max = RANDOM_MAX_COORD);
+    inline Year get_random_year(const Year min = RANDOM_MIN_YEAR, const Year max = RANDOM_MAX_YEAR);
+    std::vector<Coord> get_unique_coords(const unsigned int n,const std::unordered_set<Coord,CoordHash>& exclude_list,const Coord min=RANDOM_MIN_COORD,const Coord max=RANDOM_MAX_COORD);
+    void add_random_affiliations_publications(unsigned int size, Coord min = RANDOM_MIN_COORD, Coord max = RANDOM_MAX_COORD,const std::vector<Coord>& coordinates={});
+    Distance calc_distance(Coord c1, Coord c2);
+    std::string print_affiliation(AffiliationID id, std::ostream& output, bool nl = true);
+    std::string print_affiliation_brief(AffiliationID id, std::ostream& output, bool nl = true);
+    std::string print_publication(PublicationID id, std::ostream& output, bool nl = true);
+    std::string print_affiliation_name(AffiliationID id, std::ostream& output, bool nl = true);
+    std::string print_coord(Coord coord, std::ostream& output, bool nl = true);
+
+    template <typename Type>
+    Type random(Type start, Type end);
+    template <typename To>
+    static To convert_string_to(std::string from);
+    template <typename From>
+    static std::string convert_to_string(From from);
+
+    template<AffiliationID(Datastructures::*MFUNC)()>
+    CmdResult NoParAffiliationCmd(std::ostream& output, MatchIter begin, MatchIter end);
+
+    template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
+    CmdResult NoParListCmd(std::ostream& output, MatchIter begin, MatchIter end);
+
+    template<AffiliationID(Datastructures::*MFUNC)()>
+    void NoParAffiliationTestCmd();
+
+    template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
+    void NoParListTestCmd();
+
+    friend class MainWindow;
+};
+
+template <typename Type>
+Type MainProgram::random(Type start, Type end)
+{
+    auto range = end-start;
+    assert(range != 0 && "random() with zero range!");
+
+    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine_);
+
+    return static_cast<Type>(start+num);
+}
+
+template <typename To>
+To MainProgram::convert_string_to(std::string from)
+{
+    std::istringstream istr(from);
+    To result;
+    istr >> std::noskipws >> result;
+    if (istr.fail() || !istr.eof())
+    {
+        throw std::invalid_argument("Cannot convert string to required type");
+    }
+    return result;
+}
+
+template <typename From>
+std::string MainProgram::convert_to_string(From from)
+{
+    std::ostringstream ostr;
+    ostr << from;
+    if (ostr.fail())
+    {
+        throw std::invalid_argument("Cannot convert type to string");
+    }
+    return ostr.str();
+}
+
+template<AffiliationID(Datastructures::*MFUNC)()>
+MainProgram::CmdResult MainProgram::NoParAffiliationCmd(std::ostream& /*output*/, MatchIter /*begin*/, MatchIter /*end*/)
+{
+    auto result = (ds_.*MFUNC)();
+    return {ResultType::IDLIST, CmdResultIDs{{}, {result}}};
+}
+
+template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
+MainProgram::CmdResult MainProgram::NoParListCmd(std::ostream& /*output*/, MatchIter /*begin*/, MatchIter /*end*/)
+{
+    auto result = (ds_.*MFUNC)();
+    return {ResultType::IDLIST, CmdResultIDs{{}, result}};
+}
+
+template<AffiliationID(Datastructures::*MFUNC)()>
+void MainProgram::NoParAffiliationTestCmd()
+{
+    (ds_.*MFUNC)();
+}
+
+template<std::vector<AffiliationID>(Datastructures::*MFUNC)()>
+void MainProgram::NoParListTestCmd()
+{
+    (ds_.*MFUNC)();
+}
+
+
+// Hardware counters are used where the kernel headers for perf events exist
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#define HAS_PERF_EVENT
+#endif
+#endif
+
+#ifdef HAS_PERF_EVENT
+extern "C"
+{
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#include <asm/unistd.h>
+
+static long
+perf_event_open(struct perf_event_attr *hw_event, pid_t pid,
+                int cpu, int group_fd, unsigned long flags)
+{
+    int ret;
+
+    ret = syscall(__NR_perf_event_open, hw_event, pid, cpu,
+                   group_fd, flags);
+    return ret;
+}
+}
+#endif
+
+class MainProgram::Stopwatch
+{
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    // The counters are opened as one perf event group so that they all
+    // count exactly the same code. Counters that can't be opened are left
+    // out, and with none of them the stopwatch measures only wall time.
+    Stopwatch(std::vector<HwCounter> const& counters = {})
+    {
+#ifdef HAS_PERF_EVENT
+        for (auto counter : counters)
+        {
+            struct perf_event_attr pe;
+            memset(&pe, 0, sizeof(pe));
+            pe.size = sizeof(pe);
+            set_event(pe, counter);
+            pe.disabled = fds_.empty() ? 1 : 0; // Members follow the group leader
+            pe.exclude_kernel = 1;
+            pe.exclude_hv = 1;
+            pe.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = perf_event_open(&pe, 0, -1, fds_.empty() ? -1 : fds_.front(), 0);
+            if (fd != -1)
+            {
+                fds_.push_back(fd);
+                counters_.push_back(counter);
+            }
+        }
+#else
+        (void)counters;
+#endif
+        counts_.assign(counters_.size(), 0);
+        reset();
+    }
+
+    ~Stopwatch()
+    {
+#ifdef HAS_PERF_EVENT
+        for (auto fd : fds_)
+        {
+            close(fd);
+        }
+#endif
+    }
+
+    Stopwatch(Stopwatch const&) = delete;
+    Stopwatch& operator=(Stopwatch const&) = delete;
+
+    // The counters run outside the timed interval, so that the time doesn't
+    // include their system calls (the counts leave out the kernel anyway)
+    void start()
+    {
+        running_ = true;
+#ifdef HAS_PERF_EVENT
+        if (!fds_.empty())
+        {
+            ioctl(fds_.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        starttime_ = Clock::now();
+    }
+
+    void stop()
+    {
+        elapsed_ += (Clock::now() - starttime_);
+        running_ = false;
+#ifdef HAS_PERF_EVENT
+        if (!fds_.empty())
+        {
+            ioctl(fds_.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            read_group(counts_);
+        }
+#endif
+    }
+
+    void reset()
+    {
+        running_ = false;
+#ifdef HAS_PERF_EVENT
+        if (!fds_.empty())
+        {
+            ioctl(fds_.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        std::fill(counts_.begin(), counts_.end(), 0);
+        counts_valid_ = true;
+        elapsed_ = elapsed_.zero();
+    }
+
+    double elapsed()
+    {
+        if (!running_)
+        {
+            return static_cast<std::chrono::duration<double>>(elapsed_).count();
+        }
+        else
+        {
+            auto total = elapsed_ + (Clock::now() - starttime_);
+            return static_cast<std::chrono::duration<double>>(total).count();
+        }
+    }
+
+    // The counters that could be opened, count(i) is the value of counters()[i]
+    std::vector<HwCounter> const& counters() const
+    {
+        return counters_;
+    }
+
+    // False if the kernel couldn't fit the group on the hardware counters
+    // for a whole measured interval, so that the counts are incomplete
+    bool counts_valid() const
+    {
+        return counts_valid_;
+    }
+
+    long long count(std::size_t i)
+    {
+        assert(i < counters_.size() && "Counter not opened during Stopwatch creation!");
+        if (!running_)
+        {
+            return counts_[i];
+        }
+        std::vector<long long> counts = counts_;
+#ifdef HAS_PERF_EVENT
+        read_group(counts);
+#endif
+        return counts[i];
+    }
+
+private:
+    std::chrono::time_point<Clock> starttime_;
+    Clock::duration elapsed_ = Clock::duration::zero();
+    bool running_ = false;
+
+    std::vector<HwCounter> counters_;
+    std::vector<long long> counts_;
+    bool counts_valid_ = true;
+
+#ifdef HAS_PERF_EVENT
+    std::vector<int> fds_; // Group leader first
+
+    static void set_event(struct perf_event_attr& pe, HwCounter counter)
+    {
+        auto cache_miss = [](unsigned long long cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        pe.type = PERF_TYPE_HARDWARE;
+        switch (counter)
+        {
+            case HwCounter::CYCLES: pe.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case HwCounter::INSTRUCTIONS: pe.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case HwCounter::L1D_MISSES: pe.type = PERF_TYPE_HW_CACHE; pe.config = cache_miss(PERF_COUNT_HW_CACHE_L1D); break;
+            case HwCounter::LLC_MISSES: pe.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case HwCounter::BRANCH_MISSES: pe.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            case HwCounter::DTLB_MISSES: pe.type = PERF_TYPE_HW_CACHE; pe.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB); break;
+        }
+    }
+
+    // Adds the group's counts since the last reset to counts, scaled up if
+    // the kernel had to multiplex the counters
+    void read_group(std::vector<long long>& counts)
+    {
+        // nr, time_enabled, time_running, one value per counter
+        std::vector<unsigned long long> values(3 + fds_.size(), 0);
+        auto bytes = read(fds_.front(), values.data(), values.size() * sizeof(values[0]));
+        if (bytes != static_cast<decltype(bytes)>(values.size() * sizeof(values[0])) || values[0] != fds_.size())
+        {
+            counts_valid_ = false;
+            return;
+        }
+        unsigned long long enabled = values[1];
+        unsigned long long running = values[2];
+        if (running == 0)
+        {
+            counts_valid_ = counts_valid_ && enabled == 0;
+            return;
+        }
+        for (std::size_t i = 0; i < fds_.size(); ++i)
+        {
+            double scaled = static_cast<double>(values[3 + i]) * enabled / running;
+            counts[i] += static_cast<long long>(scaled + 0.5);
+        }
+    }
+#endif
+};
+
+
+#endif // MAINPROGRAM_HH
@@ -1,554 +1,2547 @@
-// Datastructures.cc
-//
-// Student name:Marius Cedric Ishimwe
-// Student email:marius.ishimwe@tuni.fi
-// Student number:151104952
-
-#include "datastructures.hh"
-
-#include <random>
-
-#include <cmath>
-
-#include <queue>
-
-std::minstd_rand rand_engine; // Reasonably quick pseudo-random generator
-
-template <typename Type>
-Type random_in_range(Type start, Type end)
-{
-    auto range = end-start;
-    ++range;
-
-    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine);
-
-    return static_cast<Type>(start+num);
-}
-
-// Modify the code below to implement the functionality of the class.
-// Also remove comments from the parameter names when you implement
-// an operation (Commenting out parameter name prevents compiler from
-// warning about unused parameters on operations you haven't yet implemented.)
-
-Datastructures::Datastructures()
-{
-    all_affiliations = std::vector<Affiliation>();
-    all_affiliation_ids= std::vector<AffiliationID>();
-
-    affiliation_by_ids = std::unordered_map<AffiliationID, Affiliation>();
-
-    publication_by_ids = std::unordered_map<PublicationID, Publication>();
-    affiliation_publications = std::unordered_map<AffiliationID, std::vector<PublicationID>>();
-}
-
-Datastructures::~Datastructures()
-{
-    clear_all();
-}
-
-unsigned int Datastructures::get_affiliation_count()
-{
-    return all_affiliations.size();
-}
-
-void Datastructures::clear_all()
-{
-    all_affiliations.clear();
-    all_affiliation_ids.clear();
-    affiliation_by_ids.clear();
-
-    publication_by_ids.clear();
-    affiliation_publications.clear();
-
-    std::unordered_set<Connection*> connection_set;
-
-
-        for (Connection* conn_ptr : all_connections) {
-            connection_set.insert(conn_ptr);
-        }
-
-
-        for (const auto& kvp : connection_by_id) {
-            const std::vector<Connection*>& connections = kvp.second;
-            for (Connection* conn_ptr : connections) {
-                connection_set.insert(conn_ptr);
-            }
-        }
-        for (Connection* conn_ptr : connection_set) {
-            delete conn_ptr;
-        }
-        connection_set.clear();
-        all_connections.clear();
-        connection_by_id.clear();
-}
-
-std::vector<AffiliationID> Datastructures::get_all_affiliations()
-{
-    return all_affiliation_ids;
-}
-
-bool Datastructures::add_affiliation(AffiliationID id, const Name &name, Coord xy)
-{
-    double distance = xy.x * xy.x + xy.y * xy.y;
-    Affiliation new_affiliation = {id, name, xy, distance};
-    affiliation_by_ids.insert({id, new_affiliation});
-    all_affiliations.push_back(new_affiliation);
-    all_affiliation_ids.push_back(id);
-    affiliation_publications[id] = {};
-
-    connection_by_id[id] = std::vector<Connection*>();
-    return true;
-}
-
-Name Datastructures::get_affiliation_name(AffiliationID id)
-{
-    if (affiliation_by_ids.find(id) != affiliation_by_ids.end()) {
-            return affiliation_by_ids[id].name;
-        }
-        return NO_NAME;
-}
-
-Coord Datastructures::get_affiliation_coord(AffiliationID id)
-{
-    if (affiliation_by_ids.find(id) != affiliation_by_ids.end()) {
-            return affiliation_by_ids[id].xy;
-        }
-        return NO_COORD;
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_alphabetically()
-{
-    std::vector<AffiliationID> result(all_affiliations.size());
-
-
-        std::sort(all_affiliations.begin(), all_affiliations.end(),
-                  [](const Affiliation &a, const Affiliation &b) {
-                      return a.name < b.name;
-                  });
-
-        for (std::size_t i = 0; i < all_affiliations.size(); ++i) {
-            result[i] = all_affiliations[i].id;
-        }
-        return result;
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_distance_increasing()
-{
-
-        std::sort(all_affiliations.begin(), all_affiliations.end(),
-                  [](const Affiliation &a, const Affiliation &b) {
-                      if (a.distance != b.distance) {
-                          return a.distance < b.distance;
-                      } else {
-
-                          return a.xy.y < b.xy.y;
-                      }
-                  });
-        std::vector<AffiliationID> result(all_affiliations.size());
-        for (std::size_t i = 0; i < all_affiliations.size(); ++i) {
-            result[i] = all_affiliations[i].id;
-        }
-
-        return result;
-}
-
-AffiliationID Datastructures::find_affiliation_with_coord(Coord xy)
-{
-    std::sort(all_affiliations.begin(), all_affiliations.end(), [](const Affiliation& a, const Affiliation& b) {
-            return a.xy.x < b.xy.x || (a.xy.x == b.xy.x && a.xy.y < b.xy.y);
-        });
-
-
-        auto it = std::lower_bound(all_affiliations.begin(), all_affiliations.end(), xy,
-                                   [](const Affiliation& a, const Coord& xy) {
-                                       return a.xy.x < xy.x || (a.xy.x == xy.x && a.xy.y < xy.y);
-                                   });
-
-        if (it != all_affiliations.end() && it->xy.x == xy.x && it->xy.y == xy.y) {
-            return it->id;
-        } else {
-            return NO_AFFILIATION;
-        }
-}
-
-bool Datastructures::change_affiliation_coord(AffiliationID id, Coord newcoord)
-{
-    double distance = newcoord.x * newcoord.x + newcoord.y * newcoord.y;
-
-        auto it = std::find_if(all_affiliations.begin(), all_affiliations.end(),
-                               [id](const Affiliation &affiliation) {
-                                   return affiliation.id == id;
-                               });
-
-        if (it != all_affiliations.end()) {
-
-            it->xy = newcoord;
-            it->distance = distance;
-        }
-        else {
-            return false;
-        }
-
-        if (affiliation_by_ids.find(id) != affiliation_by_ids.end()) {
-            affiliation_by_ids[id].xy = newcoord;
-            affiliation_by_ids[id].distance = distance;
-            return true;
-        }
-        return false;
-}
-
-bool Datastructures::add_publication(PublicationID id, const std::string& title, Year year, const std::vector<AffiliationID>& affiliations)
-{
-
-    Publication new_publication = {id, title, year, affiliations};
-        publication_by_ids.emplace(id, new_publication);
-        for (const auto& affid:affiliations) {
-            if (affiliation_publications.find(affid) == affiliation_publications.end()) {
-                affiliation_publications.insert({affid, std::vector<PublicationID>()});
-            }
-            affiliation_publications[affid].push_back(id);
-        }
-        create_connection(new_publication);
-        return true;
-}
-
-std::vector<PublicationID> Datastructures::all_publications()
-{
-    std::vector<PublicationID> result;
-        result.reserve(publication_by_ids.size());
-
-        for (auto it = publication_by_ids.begin(); it != publication_by_ids.end(); ++it) {
-            result.push_back(it->first);
-        }
-        return result;
-}
-
-Name Datastructures::get_publication_name(PublicationID id)
-{
-
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            return publication_by_ids[id].name;
-        }
-        return NO_NAME;
-}
-
-Year Datastructures::get_publication_year(PublicationID id)
-{
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            return publication_by_ids[id].year;
-        }
-        return NO_YEAR;
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations(PublicationID id)
-{
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            return publication_by_ids[id].by_affiliations;
-        }
-        return {NO_AFFILIATION};
-}
-
-bool Datastructures::add_reference(PublicationID id, PublicationID parentid)
-{
-    auto referencing = publication_by_ids.find(parentid);
-        auto referenced = publication_by_ids.find(id);
-        if (referencing != publication_by_ids.end() && referenced != publication_by_ids.end()) {
-            referenced->second.parent = parentid;
-            referencing->second.children.push_back(id);
-            return true;
-        }
-        return false;
-}
-
-std::vector<PublicationID> Datastructures::get_direct_references(PublicationID id)
-{
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            return publication_by_ids[id].children;
-        }
-        return {};
-}
-
-bool Datastructures::add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid)
-{
-
-    auto pub = publication_by_ids.find(publicationid);
-        if (pub != publication_by_ids.end() && affiliation_by_ids.find(affiliationid) != affiliation_by_ids.end()) {
-            pub->second.by_affiliations.push_back(affiliationid);
-            affiliation_publications[affiliationid].push_back(publicationid);
-            create_connection(pub->second, affiliationid);
-            return true;
-        }
-        return false;
-}
-
-std::vector<PublicationID> Datastructures::get_publications(AffiliationID id)
-{
-
-    if (affiliation_publications.find(id) != affiliation_publications.end()) {
-            return affiliation_publications[id];
-        }
-        return {NO_PUBLICATION};
-}
-
-PublicationID Datastructures::get_parent(PublicationID id)
-{
-
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            return publication_by_ids[id].parent;
-        }
-        return NO_PUBLICATION;
-}
-
-std::vector<std::pair<Year, PublicationID>> Datastructures::get_publications_after(AffiliationID affiliationid, Year year)
-{
-
-    if (affiliation_publications.find(affiliationid) != affiliation_publications.end()) {
-            std::vector<std::pair<Year, PublicationID>> result;
-            auto aff = affiliation_publications[affiliationid];
-            for (auto pubid : aff) {
-                if (publication_by_ids.find(pubid) != publication_by_ids.end()) {
-                    if (publication_by_ids[pubid].year >= year) {
-                        result.emplace_back(publication_by_ids[pubid].year, pubid);
-                    }
-                }
-            }
-
-            std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
-                if (a.first == b.first) {
-                    return a.second < b.second;
-                }
-                return a.first < b.first;
-            });
-
-            return result;
-        }
-        return {{NO_YEAR, NO_PUBLICATION}};
-}
-
-std::vector<PublicationID> Datastructures::get_referenced_by_chain(PublicationID id) {
-
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            auto current = publication_by_ids[id];
-            std::vector<PublicationID> result;
-            while (current.parent != NO_PUBLICATION) {
-                result.push_back(current.parent);
-                current = publication_by_ids[current.parent];
-            }
-            return result;
-        }
-        return {NO_PUBLICATION};
-}
-
-//Optional functions
-std::vector<PublicationID> Datastructures::get_all_references(PublicationID id)
-{
-
-    if (publication_by_ids.find(id) != publication_by_ids.end()) {
-            auto pub = publication_by_ids[id];
-            std::vector<PublicationID> result;
-            pre_traverse(id, result);
-            if (result.size() > 1) {
-                result.erase(result.begin());
-                return result;
-            }
-            return {};
-        }
-        else {
-            return {NO_PUBLICATION};
-        }
-}
-
-std::vector<AffiliationID> Datastructures::get_affiliations_closest_to(Coord xy)
-{
-    std::vector<std::pair<AffiliationID, Affiliation>> sortedPairs(affiliation_by_ids.begin(), affiliation_by_ids.end());
-
-
-        std::sort(sortedPairs.begin(), sortedPairs.end(), [xy](const auto& a, const auto& b) {
-
-            double distanceA = std::sqrt(std::pow(xy.x - a.second.xy.x, 2) + std::pow(xy.y - a.second.xy.y, 2));
-            double distanceB = std::sqrt(std::pow(xy.x - b.second.xy.x, 2) + std::pow(xy.y - b.second.xy.y, 2));
-            if (distanceA == distanceB) {
-                return a.second.xy.y < b.second.xy.y;
-            }
-            return distanceA < distanceB;
-
-        });
-
-        std::vector<AffiliationID> result;
-        result.reserve(3);
-        for (const auto& affiliation : sortedPairs) {
-            if (result.size() >= 3) {
-                break;
-            }
-            result.push_back(affiliation.second.id);
-        }
-        return result;
-}
-
-bool Datastructures::remove_affiliation(AffiliationID id)
-{
-    auto affit = std::find_if(all_affiliations.begin(), all_affiliations.end(),
-                                  [id](const Affiliation &affiliation) {
-                                      return affiliation.id == id;
-                                  });
-
-        if (affit != all_affiliations.end()) {
-            all_affiliations.erase(affit);
-        }
-
-
-        auto idt = find(all_affiliation_ids.begin(), all_affiliation_ids.end(),
-                        id);
-
-        if (idt != all_affiliation_ids.end()) {
-            all_affiliation_ids.erase(idt);
-        }
-
-        auto it = affiliation_by_ids.find(id);
-        if (it != affiliation_by_ids.end()) {
-
-            auto it2 = affiliation_publications.find(id);
-            if (it2 != affiliation_publications.end()) {
-                for (auto pubId : it2->second) {
-                    auto pubIt = publication_by_ids.find(pubId);
-                    if (pubIt != publication_by_ids.end()) {
-
-                        pubIt->second.by_affiliations.erase(std::remove(pubIt->second.by_affiliations.begin(),
-                                                                        pubIt->second.by_affiliations.end(),
-                                                                        id),
-                                                            pubIt->second.by_affiliations.end());
-                    }
-                }
-                affiliation_publications.erase(it2);
-            }
-            affiliation_by_ids.erase(it);
-            return true;
-        }
-        return false;
-}
-
-PublicationID Datastructures::get_closest_common_parent(PublicationID id1, PublicationID id2)
-{
-    std::vector<PublicationID> parents1 = get_referenced_by_chain(id1);
-        std::vector<PublicationID> parents2 = get_referenced_by_chain(id2);
-        for (const PublicationID& id : parents2) {
-            auto publicationIt = std::find_if(parents1.begin(), parents1.end(),
-                                              [id](const PublicationID& publicationId) {
-                                                  return publicationId == id;
-                                              });
-            if (publicationIt != parents1.end()) {
-
-                return id;
-            }
-        }
-        return NO_PUBLICATION;
-}
-
-bool Datastructures::remove_publication(PublicationID publicationid)
-{
-    auto it = publication_by_ids.find(publicationid);
-        if (it != publication_by_ids.end()) {
-
-            if (it->second.parent != NO_PUBLICATION) {
-                auto parentIt = publication_by_ids.find(it->second.parent);
-
-                auto removeIt = std::remove(parentIt->second.children.begin(), parentIt->second.children.end(), publicationid);
-                parentIt->second.children.erase(removeIt, parentIt->second.children.end());
-            }
-
-
-            if (!it->second.children.empty()) {
-                for (PublicationID child : it->second.children) {
-                    auto childIt = publication_by_ids.find(child);
-                    childIt->second.parent = NO_PUBLICATION;
-                }
-            }
-
-            if (!it->second.by_affiliations.empty()) {
-                for (AffiliationID &affiliation : it->second.by_affiliations) {
-                    auto affiliationIt = affiliation_publications.find(affiliation);
-                    if (affiliationIt != affiliation_publications.end()) {
-                        auto remove_it = std::find(affiliationIt->second.begin(), affiliationIt->second.end(), publicationid);
-                        if (remove_it != affiliationIt->second.end()) {
-                            affiliationIt->second.erase(remove_it);
-                        }
-                    }
-                }
-            }
-
-            publication_by_ids.erase(publicationid);
-            return true;
-        }
-        return false;
-}
-
-std::vector<Connection> Datastructures::get_connected_affiliations(AffiliationID id)
-{
-    if (connection_by_id.find(id) != connection_by_id.end()) {
-            std::vector<Connection> result;
-            result.reserve(connection_by_id[id].size());
-            for (const auto& ptr : connection_by_id[id]) {
-                if (ptr != nullptr) {
-                    result.emplace_back(*ptr);
-                }
-            }
-            return result;
-        }
-
-        return {};
-}
-
-std::vector<Connection> Datastructures::get_all_connections()
-{
-    std::vector<Connection> result;
-        result.reserve(all_connections.size());
-
-
-        for (const auto& ptr : all_connections) {
-            if (ptr != nullptr) {
-                result.emplace_back(*ptr);
-            }
-        }
-        return result;
-}
-
-Path Datastructures::get_any_path(AffiliationID source, AffiliationID target)
-{
-    Path path;
-        std::unordered_map<AffiliationID, bool> visited;
-
-        if (source == target) {
-            return path;
-        }
-
-        for (Connection* conn : all_connections) {
-            visited[conn->aff1] = false;
-            visited[conn->aff2] = false;
-        }
-
-        if (find_path(source, target, path, visited)) {
-            return path;
-        }
-
-        return {};
-}
-
-Path Datastructures::get_path_with_least_affiliations(AffiliationID /*source*/, AffiliationID /*target*/)
-{
-    // Replace the line below with your implementation
-    throw NotImplemented("get_path_with_least_affiliations()");
-}
-
-Path Datastructures::get_path_of_least_friction(AffiliationID /*source*/, AffiliationID /*target*/)
-{
-    // Replace the line below with your implementation
-    throw NotImplemented("get_path_of_least_friction()");
-}
-
-PathWithDist Datastructures::get_shortest_path(AffiliationID /*source*/, AffiliationID /*target*/)
-{
-    // Replace the line below with your implementation
-    throw NotImplemented("get_shortest_path()");
-}
-
-
+// Datastructures.cc
+//
+// Student name:Marius Cedric Ishimwe
+// Student email:marius.ishimwe@tuni.fi
+// Student number:151104952
+
+#include "datastructures.hh"
+
+#include <random>
+
+#include <cmath>
+
+#include <queue>
+
+#include <cstring>
+
+#include <fstream>
+
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::minstd_rand rand_engine; // Reasonably quick pseudo-random generator
+
+template <typename Type>
+Type random_in_range(Type start, Type end)
+{
+    auto range = end-start;
+    ++range;
+
+    auto num = std::uniform_int_distribution<unsigned long int>(0, range-1)(rand_engine);
+
+    return static_cast<Type>(start+num);
+}
+
+// Modify the code below to implement the functionality of the class.
+// Also remove comments from the parameter names when you implement
+// an operation (Commenting out parameter name prevents compiler from
+// warning about unused parameters on operations you haven't yet implemented.)
+
+Datastructures::Datastructures()
+{
+    affiliation_handles = std::unordered_map<AffiliationID, AffiliationHandle>();
+
+    publication_by_ids = std::unordered_map<PublicationID, Publication>();
+    affiliation_publications = std::vector<std::vector<PublicationID>>();
+    affiliation_publications_by_year = std::vector<std::vector<std::pair<Year, PublicationID>>>();
+    set_distance_kernel("auto");
+}
+
+Datastructures::~Datastructures()
+{
+    clear_all();
+}
+
+unsigned int Datastructures::get_affiliation_count()
+{
+    if (mapped.active()) {
+        return mapped.affiliation_order.size();
+    }
+    return affiliation_order.size();
+}
+
+void Datastructures::clear_all()
+{
+    release_snapshot(mapped);
+    affiliation_order.clear();
+    affiliation_handles.clear();
+    affiliations.clear();
+    affiliations_by_name.clear();
+    affiliations_by_distance.clear();
+    affiliation_by_coord.clear();
+    grid = SpatialGrid();
+    distance_scratch.clear();
+
+    publication_by_ids.clear();
+    affiliation_publications.clear();
+    affiliation_publications_by_year.clear();
+    publication_ids.clear();
+    publication_parent.clear();
+    ancestors.clear();
+    reference_depth.clear();
+    ancestors_dirty = false;
+    preorder.clear();
+    preorder_entry.clear();
+    preorder_exit.clear();
+    preorder_dirty = false;
+
+    links.clear();
+    link_by_pair.clear();
+    connection_by_handle.clear();
+    csr = CsrGraph();
+    csr_dirty = true;
+    msf_parent.clear();
+    msf_weight.clear();
+    msf_dirty = true;
+}
+
+std::vector<AffiliationID> Datastructures::get_all_affiliations()
+{
+    if (mapped.active()) {
+        std::vector<AffiliationID> result;
+        result.reserve(mapped.affiliation_order.size());
+        for (AffiliationHandle handle : mapped.affiliation_order) {
+            result.emplace_back(mapped.affiliation_id(handle));
+        }
+        return result;
+    }
+    std::vector<AffiliationID> result;
+    result.reserve(affiliation_order.size());
+    for (AffiliationHandle handle : affiliation_order) {
+        result.emplace_back(affiliations.id(handle));
+    }
+    return result;
+}
+
+bool Datastructures::add_affiliation(AffiliationID id, const Name &name, Coord xy)
+{
+    ensure_heap();
+    AffiliationHandle handle = intern(id);
+    if (affiliations.exists[handle]) {
+        return false;
+    }
+    affiliations.exists[handle] = 1;
+    affiliations.set_name(handle, name);
+    affiliations.set_xy(handle, xy);
+    affiliation_order.push_back(handle);
+
+    affiliations_by_name.insert(handle);
+    affiliations_by_distance.insert({affiliations.distances[handle], xy.y, handle});
+    affiliation_by_coord.emplace(xy, handle);
+    grid_insert(handle);
+    return true;
+}
+
+Name Datastructures::get_affiliation_name(AffiliationID id)
+{
+    AffiliationHandle handle = find_existing(id);
+    if (handle != NO_HANDLE) {
+        return Name(mapped.active() ? mapped.affiliation_name(handle) : affiliations.name(handle));
+    }
+    return NO_NAME;
+}
+
+Coord Datastructures::get_affiliation_coord(AffiliationID id)
+{
+    AffiliationHandle handle = find_existing(id);
+    if (handle != NO_HANDLE) {
+        return affiliation_xy(handle);
+    }
+    return NO_COORD;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_alphabetically()
+{
+    ensure_heap();
+    std::vector<AffiliationID> result;
+    result.reserve(affiliations_by_name.size());
+    for (AffiliationHandle handle : affiliations_by_name) {
+        result.emplace_back(affiliations.id(handle));
+    }
+    return result;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_distance_increasing()
+{
+    ensure_heap();
+    std::vector<AffiliationID> result;
+    result.reserve(affiliations_by_distance.size());
+    for (const auto& entry : affiliations_by_distance) {
+        result.emplace_back(affiliations.id(std::get<2>(entry)));
+    }
+    return result;
+}
+
+AffiliationID Datastructures::find_affiliation_with_coord(Coord xy)
+{
+    ensure_heap();
+    // The smallest id when several affiliations share the coordinate
+    auto [first, last] = affiliation_by_coord.equal_range(xy);
+    if (first == last) {
+        return NO_AFFILIATION;
+    }
+    std::string_view found = affiliations.id(first->second);
+    for (auto it = std::next(first); it != last; ++it) {
+        found = std::min(found, affiliations.id(it->second));
+    }
+    return AffiliationID(found);
+}
+
+void Datastructures::erase_coord_owner(AffiliationHandle handle)
+{
+    auto [first, last] = affiliation_by_coord.equal_range(affiliations.xy(handle));
+    for (auto it = first; it != last; ++it) {
+        if (it->second == handle) {
+            affiliation_by_coord.erase(it);
+            return;
+        }
+    }
+}
+
+bool Datastructures::change_affiliation_coord(AffiliationID id, Coord newcoord)
+{
+    ensure_heap();
+    AffiliationHandle handle = find_existing(id);
+    if (handle == NO_HANDLE) {
+        return false;
+    }
+    affiliations_by_distance.erase({affiliations.distances[handle], affiliations.ys[handle], handle});
+    erase_coord_owner(handle);
+    grid_erase(handle);
+
+    affiliations.set_xy(handle, newcoord);
+
+    affiliations_by_distance.insert({affiliations.distances[handle], newcoord.y, handle});
+    affiliation_by_coord.emplace(newcoord, handle);
+    grid_insert(handle);
+    return true;
+}
+
+bool Datastructures::add_publication(PublicationID id, const std::string& title, Year year, const std::vector<AffiliationID>& affiliations)
+{
+    ensure_heap();
+    if (publication_by_ids.find(id) != publication_by_ids.end()) {
+        return false;
+    }
+    Publication new_publication = {id, title, year, {}};
+    new_publication.handle = new_publication_handle(id);
+    new_publication.by_affiliations.reserve(affiliations.size());
+    for (const auto& affid : affiliations) {
+        AffiliationHandle handle = intern(affid);
+        new_publication.by_affiliations.push_back(handle);
+        affiliation_publications[handle].push_back(id);
+        index_publication_year(handle, year, id);
+    }
+    auto it = publication_by_ids.emplace(id, std::move(new_publication)).first;
+    create_connection(it->second);
+    return true;
+}
+
+std::vector<PublicationID> Datastructures::all_publications()
+{
+    if (mapped.active()) {
+        std::vector<PublicationID> result;
+        result.reserve(mapped.publications_by_id.size());
+        for (PublicationHandle handle : mapped.publications_by_id) {
+            result.push_back(mapped.publication_ids[handle]);
+        }
+        return result;
+    }
+    std::vector<PublicationID> result;
+        result.reserve(publication_by_ids.size());
+
+        for (auto it = publication_by_ids.begin(); it != publication_by_ids.end(); ++it) {
+            result.push_back(it->first);
+        }
+        return result;
+}
+
+Name Datastructures::get_publication_name(PublicationID id)
+{
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        return handle != NO_HANDLE ? Name(mapped.publication_name(handle)) : NO_NAME;
+    }
+
+    if (publication_by_ids.find(id) != publication_by_ids.end()) {
+            return publication_by_ids[id].name;
+        }
+        return NO_NAME;
+}
+
+Year Datastructures::get_publication_year(PublicationID id)
+{
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        return handle != NO_HANDLE ? mapped.publication_years[handle] : NO_YEAR;
+    }
+    if (publication_by_ids.find(id) != publication_by_ids.end()) {
+            return publication_by_ids[id].year;
+        }
+        return NO_YEAR;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations(PublicationID id)
+{
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        if (handle == NO_HANDLE) {
+            return {NO_AFFILIATION};
+        }
+        std::vector<AffiliationID> result;
+        for (AffiliationHandle affiliation : MappedSnapshot::slice(mapped.publication_affiliation_offsets, mapped.publication_affiliations, handle)) {
+            result.emplace_back(mapped.affiliation_id(affiliation));
+        }
+        return result;
+    }
+    auto it = publication_by_ids.find(id);
+    if (it != publication_by_ids.end()) {
+        std::vector<AffiliationID> result;
+        result.reserve(it->second.by_affiliations.size());
+        for (AffiliationHandle handle : it->second.by_affiliations) {
+            result.emplace_back(affiliations.id(handle));
+        }
+        return result;
+    }
+    return {NO_AFFILIATION};
+}
+
+bool Datastructures::add_reference(PublicationID id, PublicationID parentid)
+{
+    ensure_heap();
+    auto referencing = publication_by_ids.find(parentid);
+        auto referenced = publication_by_ids.find(id);
+        if (referencing != publication_by_ids.end() && referenced != publication_by_ids.end()) {
+            referenced->second.parent = parentid;
+            referencing->second.children.push_back(id);
+            attach_reference(referenced->second.handle, referencing->second.handle, !referenced->second.children.empty());
+            preorder_dirty = true;
+            return true;
+        }
+        return false;
+}
+
+std::vector<PublicationID> Datastructures::get_direct_references(PublicationID id)
+{
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        if (handle == NO_HANDLE) {
+            return {};
+        }
+        auto children = MappedSnapshot::slice(mapped.publication_child_offsets, mapped.publication_children, handle);
+        return std::vector<PublicationID>(children.begin(), children.end());
+    }
+    if (publication_by_ids.find(id) != publication_by_ids.end()) {
+            return publication_by_ids[id].children;
+        }
+        return {};
+}
+
+bool Datastructures::add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid)
+{
+    ensure_heap();
+    auto pub = publication_by_ids.find(publicationid);
+    AffiliationHandle handle = find_existing(affiliationid);
+    if (pub != publication_by_ids.end() && handle != NO_HANDLE) {
+        pub->second.by_affiliations.push_back(handle);
+        affiliation_publications[handle].push_back(publicationid);
+        index_publication_year(handle, pub->second.year, publicationid);
+        create_connection(pub->second, handle);
+        return true;
+    }
+    return false;
+}
+
+std::vector<PublicationID> Datastructures::get_publications(AffiliationID id)
+{
+    AffiliationHandle handle = find_handle(id);
+    if (handle != NO_HANDLE && mapped.active()) {
+        auto publications = MappedSnapshot::slice(mapped.affiliation_publication_offsets, mapped.affiliation_publications, handle);
+        return std::vector<PublicationID>(publications.begin(), publications.end());
+    }
+    if (handle != NO_HANDLE) {
+        return affiliation_publications[handle];
+    }
+    return {NO_PUBLICATION};
+}
+
+PublicationID Datastructures::get_parent(PublicationID id)
+{
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        if (handle == NO_HANDLE || mapped.publication_parents[handle] == NO_HANDLE) {
+            return NO_PUBLICATION;
+        }
+        return mapped.publication_ids[mapped.publication_parents[handle]];
+    }
+
+    if (publication_by_ids.find(id) != publication_by_ids.end()) {
+            return publication_by_ids[id].parent;
+        }
+        return NO_PUBLICATION;
+}
+
+std::vector<std::pair<Year, PublicationID>> Datastructures::get_publications_after(AffiliationID affiliationid, Year year)
+{
+    ensure_heap();
+    AffiliationHandle handle = find_handle(affiliationid);
+    if (handle == NO_HANDLE) {
+        return {{NO_YEAR, NO_PUBLICATION}};
+    }
+    const auto& publications = affiliation_publications_by_year[handle];
+    auto first = std::lower_bound(publications.begin(), publications.end(), std::make_pair(year, PublicationID(0)));
+    return std::vector<std::pair<Year, PublicationID>>(first, publications.end());
+}
+
+std::vector<PublicationID> Datastructures::get_referenced_by_chain(PublicationID id) {
+    if (mapped.active()) {
+        PublicationHandle handle = mapped.find_publication(id);
+        if (handle == NO_HANDLE) {
+            return {NO_PUBLICATION};
+        }
+        std::vector<PublicationID> result;
+        for (PublicationHandle ancestor : reference_chain(handle)) {
+            result.push_back(mapped.publication_ids[ancestor]);
+        }
+        return result;
+    }
+
+    auto it = publication_by_ids.find(id);
+    if (it == publication_by_ids.end()) {
+        return {NO_PUBLICATION};
+    }
+    PublicationHandle handle = it->second.handle;
+    std::vector<PublicationID> result;
+    if (!ancestors_dirty) {
+        result.reserve(reference_depth[handle]);
+    }
+    for (PublicationHandle ancestor : reference_chain(handle)) {
+        result.push_back(publication_ids[ancestor]);
+    }
+    return result;
+}
+
+//Optional functions
+std::vector<PublicationID> Datastructures::get_all_references(PublicationID id)
+{
+    ensure_heap();
+    auto it = publication_by_ids.find(id);
+    if (it == publication_by_ids.end()) {
+        return {NO_PUBLICATION};
+    }
+    if (preorder_dirty) {
+        rebuild_preorder();
+    }
+    PublicationHandle handle = it->second.handle;
+    std::vector<PublicationID> result;
+    result.reserve(preorder_exit[handle] - preorder_entry[handle] - 1);
+    for (std::uint32_t index = preorder_entry[handle] + 1; index < preorder_exit[handle]; ++index) {
+        result.push_back(publication_ids[preorder[index]]);
+    }
+    return result;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_closest_to(Coord xy)
+{
+    ensure_heap();
+    std::vector<AffiliationID> result;
+    result.reserve(3);
+    for (AffiliationHandle handle : grid_nearest(xy, 3)) {
+        result.emplace_back(affiliations.id(handle));
+    }
+    return result;
+}
+
+namespace
+{
+// Squared distances from a point to every slot of the coordinate columns.
+// The differences are taken as unsigned max - min, which fits 32 bits, and
+// their squares fit 64 bits. The sum of the two squares can still exceed
+// LLONG_MAX when a difference is 2^31 or more (only possible with
+// coordinates of both signs), so it saturates at LLONG_MAX: such far away
+// slots compare equal to each other but remain farther than the rest.
+void scalar_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        unsigned long long dx = xs[i] > from.x ? 0ULL + xs[i] - from.x : 0ULL + from.x - xs[i];
+        unsigned long long dy = ys[i] > from.y ? 0ULL + ys[i] - from.y : 0ULL + from.y - ys[i];
+        unsigned long long square = dx * dx;
+        unsigned long long sum = square + dy * dy;
+        bool saturated = sum < square || sum > static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+        distances[i] = saturated ? std::numeric_limits<long long>::max() : static_cast<long long>(sum);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_DISTANCE_KERNELS
+
+// The vector kernels don't saturate. They collect the top bits of all the
+// differences instead, and leave the call to the scalar kernel if any is
+// set, since below 2^31 the sum of two squares stays below 2^63.
+
+// |a - b| of signed 32 bit lanes as unsigned 32 bit lanes
+__attribute__((target("sse2"))) inline __m128i sse2_abs_diff(__m128i a, __m128i b)
+{
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    __m128i high = _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+    __m128i low = _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+    return _mm_sub_epi32(high, low);
+}
+
+__attribute__((target("sse2")))
+void sse2_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    __m128i from_x = _mm_set1_epi32(from.x);
+    __m128i from_y = _mm_set1_epi32(from.y);
+    __m128i differences = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i dx = sse2_abs_diff(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i)), from_x);
+        __m128i dy = sse2_abs_diff(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i)), from_y);
+        differences = _mm_or_si128(differences, _mm_or_si128(dx, dy));
+        // 32 x 32 -> 64 bit products of the even lanes, then of the odd ones
+        __m128i even = _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy));
+        dx = _mm_srli_epi64(dx, 32);
+        dy = _mm_srli_epi64(dy, 32);
+        __m128i odd = _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i), _mm_unpacklo_epi64(even, odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i + 2), _mm_unpackhi_epi64(even, odd));
+    }
+    if (_mm_movemask_ps(_mm_castsi128_ps(differences)) != 0) {
+        i = 0;
+    }
+    scalar_square_distances(xs + i, ys + i, count - i, from, distances + i);
+}
+
+__attribute__((target("avx2")))
+void avx2_square_distances(const int* xs, const int* ys, std::size_t count, Coord from, long long* distances)
+{
+    __m256i from_x = _mm256_set1_epi32(from.x);
+    __m256i from_y = _mm256_set1_epi32(from.y);
+    __m256i differences = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i));
+        __m256i dx = _mm256_sub_epi32(_mm256_max_epi32(x, from_x), _mm256_min_epi32(x, from_x));
+        __m256i dy = _mm256_sub_epi32(_mm256_max_epi32(y, from_y), _mm256_min_epi32(y, from_y));
+        differences = _mm256_or_si256(differences, _mm256_or_si256(dx, dy));
+        __m256i even = _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy));
+        dx = _mm256_srli_epi64(dx, 32);
+        dy = _mm256_srli_epi64(dy, 32);
+        __m256i odd = _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy));
+        // Unpacking interleaves within 128 bit halves: [0 1 | 4 5] and [2 3 | 6 7]
+        __m256i low = _mm256_unpacklo_epi64(even, odd);
+        __m256i high = _mm256_unpackhi_epi64(even, odd);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + i), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + i + 4), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    if (_mm256_movemask_ps(_mm256_castsi256_ps(differences)) != 0) {
+        i = 0;
+    }
+    scalar_square_distances(xs + i, ys + i, count - i, from, distances + i);
+}
+#endif
+
+bool cpu_has_kernel(const std::string& name)
+{
+#ifdef HAS_X86_DISTANCE_KERNELS
+    __builtin_cpu_init();
+    if (name == "avx2") {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (name == "sse2") {
+        return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return name == "scalar";
+}
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_closest_to_k(Coord xy, unsigned int k)
+{
+    ensure_heap();
+    square_distances(xy);
+    std::vector<std::pair<long long, AffiliationHandle>> candidates;
+    candidates.reserve(affiliation_order.size());
+    for (AffiliationHandle handle = 0; handle < affiliations.size(); ++handle) {
+        if (affiliations.exists[handle]) {
+            candidates.emplace_back(distance_scratch[handle], handle);
+        }
+    }
+    auto closer = [this](const std::pair<long long, AffiliationHandle>& a, const std::pair<long long, AffiliationHandle>& b) {
+        return nearer(a, b);
+    };
+    if (k < candidates.size()) {
+        std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), closer);
+        candidates.resize(k);
+    }
+    std::sort(candidates.begin(), candidates.end(), closer);
+
+    std::vector<AffiliationID> result;
+    result.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        result.emplace_back(affiliations.id(candidate.second));
+    }
+    return result;
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_within_radius(Coord xy, int radius)
+{
+    ensure_heap();
+    if (radius < 0) {
+        return {};
+    }
+    square_distances(xy);
+    long long limit = static_cast<long long>(radius) * radius;
+    std::vector<std::pair<long long, AffiliationHandle>> matches;
+    for (AffiliationHandle handle = 0; handle < affiliations.size(); ++handle) {
+        if (distance_scratch[handle] <= limit && affiliations.exists[handle]) {
+            matches.emplace_back(distance_scratch[handle], handle);
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [this](const std::pair<long long, AffiliationHandle>& a, const std::pair<long long, AffiliationHandle>& b) {
+        return nearer(a, b);
+    });
+
+    std::vector<AffiliationID> result;
+    result.reserve(matches.size());
+    for (const auto& match : matches) {
+        result.emplace_back(affiliations.id(match.second));
+    }
+    return result;
+}
+
+std::string Datastructures::set_distance_kernel(const std::string& name)
+{
+    // Widest first, so that "auto" takes the first one available
+    static const std::pair<const char*, DistanceKernel> kernels[] = {
+        {"avx2", DistanceKernel::AVX2}, {"sse2", DistanceKernel::SSE2}, {"scalar", DistanceKernel::SCALAR}};
+    for (const auto& [kernel_name, kernel] : kernels) {
+        if ((name == "auto" || name == kernel_name) && cpu_has_kernel(kernel_name)) {
+            distance_kernel = kernel;
+            return kernel_name;
+        }
+    }
+    return "";
+}
+
+void Datastructures::square_distances(Coord xy)
+{
+    distance_scratch.resize(affiliations.size());
+    const int* xs = affiliations.xs.data();
+    const int* ys = affiliations.ys.data();
+    switch (distance_kernel) {
+#ifdef HAS_X86_DISTANCE_KERNELS
+    case DistanceKernel::AVX2:
+        avx2_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+    case DistanceKernel::SSE2:
+        sse2_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+#endif
+    default:
+        scalar_square_distances(xs, ys, affiliations.size(), xy, distance_scratch.data());
+        break;
+    }
+}
+
+std::vector<AffiliationID> Datastructures::get_affiliations_in_rect(Coord min, Coord max)
+{
+    ensure_heap();
+    if (min.x > max.x || min.y > max.y) {
+        return {};
+    }
+    ensure_grid();
+
+    std::vector<AffiliationHandle> inside;
+    auto scan_cell = [&](const std::vector<AffiliationHandle>& handles) {
+        for (AffiliationHandle handle : handles) {
+            int x = affiliations.xs[handle];
+            int y = affiliations.ys[handle];
+            if (min.x <= x && x <= max.x && min.y <= y && y <= max.y) {
+                inside.push_back(handle);
+            }
+        }
+    };
+    long long from_x = std::max(grid_cell(min.x), grid.min_x);
+    long long to_x = std::min(grid_cell(max.x), grid.max_x);
+    long long from_y = std::max(grid_cell(min.y), grid.min_y);
+    long long to_y = std::min(grid_cell(max.y), grid.max_y);
+    if (grid.count > 0 && from_x <= to_x && from_y <= to_y) {
+        // A rectangle over mostly empty cells is cheaper to answer from the
+        // occupied cells
+        if (static_cast<double>(to_x - from_x + 1) * static_cast<double>(to_y - from_y + 1) > grid.cells.size()) {
+            for (const auto& cell : grid.cells) {
+                scan_cell(cell.second);
+            }
+        } else {
+            for (long long cell_y = from_y; cell_y <= to_y; ++cell_y) {
+                for (long long cell_x = from_x; cell_x <= to_x; ++cell_x) {
+                    auto cell = grid.cells.find(grid_key(cell_x, cell_y));
+                    if (cell != grid.cells.end()) {
+                        scan_cell(cell->second);
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(inside.begin(), inside.end(), [this](AffiliationHandle a, AffiliationHandle b) {
+        if (affiliations.ys[a] != affiliations.ys[b]) {
+            return affiliations.ys[a] < affiliations.ys[b];
+        }
+        if (affiliations.xs[a] != affiliations.xs[b]) {
+            return affiliations.xs[a] < affiliations.xs[b];
+        }
+        return affiliations.id(a) < affiliations.id(b);
+    });
+    std::vector<AffiliationID> result;
+    result.reserve(inside.size());
+    for (AffiliationHandle handle : inside) {
+        result.emplace_back(affiliations.id(handle));
+    }
+    return result;
+}
+
+std::pair<Coord, Coord> Datastructures::get_affiliation_extent()
+{
+    const CoordBox& extent = mapped.active() ? mapped.extent : affiliations.extent;
+    if (extent.empty()) {
+        return {NO_COORD, NO_COORD};
+    }
+    return {extent.min, extent.max};
+}
+
+bool Datastructures::remove_affiliation(AffiliationID id)
+{
+    ensure_heap();
+        AffiliationHandle handle = find_existing(id);
+        if (handle != NO_HANDLE) {
+            affiliation_order.erase(std::find(affiliation_order.begin(), affiliation_order.end(), handle));
+            affiliations_by_name.erase(handle);
+            affiliations_by_distance.erase({affiliations.distances[handle], affiliations.ys[handle], handle});
+            erase_coord_owner(handle);
+            grid_erase(handle);
+
+            for (auto pubId : affiliation_publications[handle]) {
+                auto pubIt = publication_by_ids.find(pubId);
+                if (pubIt != publication_by_ids.end()) {
+
+                    pubIt->second.by_affiliations.erase(std::remove(pubIt->second.by_affiliations.begin(),
+                                                                    pubIt->second.by_affiliations.end(),
+                                                                    handle),
+                                                        pubIt->second.by_affiliations.end());
+                }
+            }
+            affiliation_publications[handle].clear();
+            affiliation_publications_by_year[handle].clear();
+
+            // The handle slot stays behind so that links pointing at it remain
+            // valid, but the id no longer resolves to it
+            affiliations.exists[handle] = 0;
+            affiliation_handles.erase(id);
+            return true;
+        }
+        return false;
+}
+
+PublicationID Datastructures::get_closest_common_parent(PublicationID id1, PublicationID id2)
+{
+    ensure_heap();
+    auto first = publication_by_ids.find(id1);
+    auto second = publication_by_ids.find(id2);
+    if (first == publication_by_ids.end() || second == publication_by_ids.end()) {
+        return NO_PUBLICATION;
+    }
+    // The closest common parent is the lowest common ancestor of the parents
+    PublicationHandle first_parent = publication_parent[first->second.handle];
+    PublicationHandle second_parent = publication_parent[second->second.handle];
+    if (first_parent == NO_HANDLE || second_parent == NO_HANDLE) {
+        return NO_PUBLICATION;
+    }
+    if (ancestors_dirty) {
+        rebuild_ancestors();
+    }
+    PublicationHandle common = common_ancestor(first_parent, second_parent);
+    return common != NO_HANDLE ? publication_ids[common] : NO_PUBLICATION;
+}
+
+bool Datastructures::remove_publication(PublicationID publicationid)
+{
+    ensure_heap();
+    auto it = publication_by_ids.find(publicationid);
+        if (it != publication_by_ids.end()) {
+
+            if (it->second.parent != NO_PUBLICATION) {
+                auto parentIt = publication_by_ids.find(it->second.parent);
+
+                auto removeIt = std::remove(parentIt->second.children.begin(), parentIt->second.children.end(), publicationid);
+                parentIt->second.children.erase(removeIt, parentIt->second.children.end());
+            }
+
+
+            if (!it->second.children.empty()) {
+                for (PublicationID child : it->second.children) {
+                    auto childIt = publication_by_ids.find(child);
+                    childIt->second.parent = NO_PUBLICATION;
+                    publication_parent[childIt->second.handle] = NO_HANDLE;
+                }
+                // The children become roots of their own trees
+                ancestors_dirty = true;
+            }
+            // A removed leaf is nobody's ancestor, so its slot can simply stay
+            publication_parent[it->second.handle] = NO_HANDLE;
+            publication_ids[it->second.handle] = NO_PUBLICATION;
+            preorder_dirty = true;
+
+            for (AffiliationHandle handle : it->second.by_affiliations) {
+                auto& publications = affiliation_publications[handle];
+                auto remove_it = std::find(publications.begin(), publications.end(), publicationid);
+                if (remove_it != publications.end()) {
+                    publications.erase(remove_it);
+                }
+                unindex_publication_year(handle, it->second.year, publicationid);
+            }
+
+            publication_by_ids.erase(publicationid);
+            return true;
+        }
+        return false;
+}
+
+std::vector<Connection> Datastructures::get_connected_affiliations(AffiliationID id)
+{
+    AffiliationHandle handle = find_handle(id);
+    if (handle == NO_HANDLE) {
+        return {};
+    }
+    std::vector<Connection> result;
+    if (mapped.active()) {
+        // The adjacency arrays list the connections in the same order
+        GraphView graph = connection_graph();
+        for (std::uint32_t edge = graph.offsets[handle]; edge < graph.offsets[handle + 1]; ++edge) {
+            result.push_back(to_connection(handle, graph.neighbours[edge], graph.weights[edge]));
+        }
+        return result;
+    }
+    result.reserve(connection_by_handle[handle].size());
+    for (LinkIndex index : connection_by_handle[handle]) {
+        const Link& link = links[index];
+        result.push_back(to_connection(handle, link_other(link, handle), link.weight));
+    }
+    return result;
+}
+
+std::vector<Connection> Datastructures::get_all_connections()
+{
+    ArrayView<Link> all_links = mapped.active() ? mapped.links : view_of(links);
+    std::vector<Connection> result;
+    result.reserve(all_links.size());
+    for (const Link& link : all_links) {
+        result.push_back(to_connection(link));
+    }
+    return result;
+}
+
+Path Datastructures::get_any_path(AffiliationID source, AffiliationID target)
+{
+    Path path;
+    AffiliationHandle source_handle = find_handle(source);
+    AffiliationHandle target_handle = find_handle(target);
+
+    if (source == target || source_handle == NO_HANDLE || target_handle == NO_HANDLE) {
+        return path;
+    }
+
+    last_search_expansions = 0;
+    find_path(source_handle, target_handle, path);
+    return path;
+}
+
+Path Datastructures::get_path_with_least_affiliations(AffiliationID source, AffiliationID target)
+{
+    last_search_expansions = 0;
+    AffiliationHandle source_handle = find_handle(source);
+    AffiliationHandle target_handle = find_handle(target);
+    if (source == target || source_handle == NO_HANDLE || target_handle == NO_HANDLE) {
+        return {};
+    }
+    return bidirectional_bfs(source_handle, target_handle);
+}
+
+Path Datastructures::get_path_of_least_friction(AffiliationID source, AffiliationID target)
+{
+    last_search_expansions = 0;
+    AffiliationHandle source_handle = find_handle(source);
+    AffiliationHandle target_handle = find_handle(target);
+    if (source == target || source_handle == NO_HANDLE || target_handle == NO_HANDLE) {
+        return {};
+    }
+    if (msf_dirty && !mapped.active()) {
+        rebuild_spanning_forest();
+    }
+
+    // The forest path gives the best achievable bottleneck, the BFS then picks
+    // the path with fewest connections among those reaching it
+    Weight bottleneck = NO_WEIGHT;
+    AffiliationHandle bottleneck_child = NO_HANDLE;
+    if (!spanning_path_minimum(source_handle, target_handle, bottleneck, bottleneck_child)) {
+        return {};
+    }
+    return bidirectional_bfs(source_handle, target_handle, bottleneck);
+}
+
+PathWithDist Datastructures::get_shortest_path(AffiliationID source, AffiliationID target)
+{
+    last_search_expansions = 0;
+    AffiliationHandle source_handle = find_existing(source);
+    AffiliationHandle target_handle = find_existing(target);
+    if (source == target || source_handle == NO_HANDLE || target_handle == NO_HANDLE) {
+        return {};
+    }
+    return shortest_path_search(source_handle, target_handle);
+}
+
+void Datastructures::connect(AffiliationHandle first, AffiliationHandle second)
+{
+    csr_dirty = true;
+    AffiliationHandle source = first;
+    AffiliationHandle target = second;
+    if (affiliations.id(target) < affiliations.id(source)) {
+        std::swap(source, target);
+    }
+
+    auto [it, inserted] = link_by_pair.try_emplace(link_key(source, target), static_cast<LinkIndex>(links.size()));
+    if (!inserted) {
+        Link& link = links[it->second];
+        link.weight += 1;
+        if (!msf_dirty) {
+            update_spanning_forest(source, target, link.weight);
+        }
+        return;
+    }
+
+    LinkIndex index = it->second;
+    links.push_back({source, target, 1});
+    connection_by_handle[source].push_back(index);
+    connection_by_handle[target].push_back(index);
+    if (!msf_dirty) {
+        update_spanning_forest(source, target, 1);
+    }
+}
+
+bool Datastructures::find_path(AffiliationHandle source, AffiliationHandle target, Path& path)
+{
+    GraphView graph = connection_graph();
+    forward_search.begin(graph.offsets.size() - 1);
+    forward_search.visit(source, NO_HANDLE, 0, 0);
+    dfs_stack.clear();
+    dfs_stack.push_back({source, graph.offsets[source]});
+    ++last_search_expansions;
+
+    while (!dfs_stack.empty()) {
+        AffiliationHandle current = dfs_stack.back().first;
+        std::uint32_t edge = dfs_stack.back().second;
+        if (edge == graph.offsets[current + 1]) {
+            dfs_stack.pop_back();
+            continue;
+        }
+        ++dfs_stack.back().second;
+
+        AffiliationHandle next = graph.neighbours[edge];
+        if (forward_search.visited(next)) {
+            continue;
+        }
+        if (next == target) {
+            // The edge taken from each stack entry is the one just before its cursor
+            path.reserve(dfs_stack.size());
+            for (std::size_t i = 0; i + 1 < dfs_stack.size(); ++i) {
+                std::uint32_t taken = dfs_stack[i].second - 1;
+                path.push_back(to_connection(dfs_stack[i].first, dfs_stack[i + 1].first, graph.weights[taken]));
+            }
+            path.push_back(to_connection(current, next, graph.weights[edge]));
+            return true;
+        }
+        forward_search.visit(next, current, edge, 0);
+        dfs_stack.push_back({next, graph.offsets[next]});
+        ++last_search_expansions;
+    }
+    return false;
+}
+
+unsigned int Datastructures::get_last_search_expansions()
+{
+    return last_search_expansions;
+}
+
+void Datastructures::set_shortest_path_heuristic(bool enabled)
+{
+    shortest_path_heuristic = enabled;
+}
+
+unsigned int Datastructures::get_reference_count(PublicationID id)
+{
+    ensure_heap();
+    auto it = publication_by_ids.find(id);
+    if (it == publication_by_ids.end()) {
+        return 0;
+    }
+    if (preorder_dirty) {
+        rebuild_preorder();
+    }
+    PublicationHandle handle = it->second.handle;
+    return preorder_exit[handle] - preorder_entry[handle] - 1;
+}
+
+bool Datastructures::is_referenced_by(PublicationID id, PublicationID ancestorid)
+{
+    ensure_heap();
+    auto it = publication_by_ids.find(id);
+    auto ancestor = publication_by_ids.find(ancestorid);
+    if (it == publication_by_ids.end() || ancestor == publication_by_ids.end() || id == ancestorid) {
+        return false;
+    }
+    if (preorder_dirty) {
+        rebuild_preorder();
+    }
+    std::uint32_t entry = preorder_entry[it->second.handle];
+    PublicationHandle handle = ancestor->second.handle;
+    return preorder_entry[handle] < entry && entry < preorder_exit[handle];
+}
+
+namespace
+{
+// Makes room for count elements, at least doubling the capacity when it
+// has to grow, so that a run of small bulk adds doesn't reallocate every time
+template <typename Type>
+void grow_capacity(std::vector<Type>& values, std::size_t count)
+{
+    if (count > values.capacity()) {
+        values.reserve(std::max(count, 2 * values.capacity()));
+    }
+}
+
+template <typename Key, typename Value, typename Hash>
+void grow_capacity(std::unordered_map<Key, Value, Hash>& map, std::size_t count)
+{
+    if (count > map.bucket_count() * map.max_load_factor()) {
+        map.reserve(std::max(count, 2 * map.size()));
+    }
+}
+
+template <typename Key, typename Value, typename Hash>
+void grow_capacity(std::unordered_multimap<Key, Value, Hash>& map, std::size_t count)
+{
+    if (count > map.bucket_count() * map.max_load_factor()) {
+        map.reserve(std::max(count, 2 * map.size()));
+    }
+}
+}
+
+unsigned int Datastructures::add_affiliations_bulk(const std::vector<AffiliationRecord>& records)
+{
+    ensure_heap();
+    std::size_t count = affiliations.size() + records.size();
+    grow_capacity(affiliation_handles, count);
+    if (count > affiliations.xs.capacity()) {
+        affiliations.reserve(std::max(count, 2 * affiliations.xs.capacity()));
+    }
+    grow_capacity(affiliation_publications, count);
+    grow_capacity(affiliation_publications_by_year, count);
+    grow_capacity(connection_by_handle, count);
+    grow_capacity(msf_parent, count);
+    grow_capacity(msf_weight, count);
+    grow_capacity(affiliation_order, affiliation_order.size() + records.size());
+    grow_capacity(affiliation_by_coord, affiliation_by_coord.size() + records.size());
+
+    // The grid would be rebuilt by its next query anyway
+    if (grid.cell_size != 0 && grid.count + records.size() > 2 * grid.built_count + 16) {
+        grid = SpatialGrid();
+    }
+
+    // New entries of the ordered indexes are collected and sorted, so that
+    // each can be inserted with its predecessor as the hint
+    std::vector<std::pair<std::string_view, AffiliationHandle>> by_name;
+    std::vector<std::tuple<long long, int, AffiliationHandle>> by_distance;
+    by_name.reserve(records.size());
+    by_distance.reserve(records.size());
+    for (const AffiliationRecord& record : records) {
+        AffiliationHandle handle = intern(record.id);
+        if (affiliations.exists[handle]) {
+            continue;
+        }
+        affiliations.exists[handle] = 1;
+        affiliations.set_name(handle, record.name);
+        affiliations.set_xy(handle, record.xy);
+        affiliation_order.push_back(handle);
+        by_name.emplace_back(std::string_view(), handle);
+        by_distance.emplace_back(affiliations.distances[handle], record.xy.y, handle);
+        affiliation_by_coord.emplace(record.xy, handle);
+        grid_insert(handle);
+    }
+    // Names are sorted next to their handles rather than through the table,
+    // once the arena has stopped growing
+    for (auto& entry : by_name) {
+        entry.first = affiliations.name(entry.second);
+    }
+    std::sort(by_name.begin(), by_name.end());
+    std::sort(by_distance.begin(), by_distance.end());
+    // The hint is the successor of the previous insert, which is amortized
+    // O(1) as long as no existing entry lies between consecutive new ones
+    auto name_hint = affiliations_by_name.begin();
+    for (const auto& entry : by_name) {
+        name_hint = std::next(affiliations_by_name.insert(name_hint, entry.second));
+    }
+    auto distance_hint = affiliations_by_distance.begin();
+    for (const auto& entry : by_distance) {
+        distance_hint = std::next(affiliations_by_distance.insert(distance_hint, entry));
+    }
+    return by_name.size();
+}
+
+unsigned int Datastructures::add_publications_bulk(const std::vector<PublicationRecord>& records)
+{
+    ensure_heap();
+    std::size_t count = publication_ids.size() + records.size();
+    grow_capacity(publication_by_ids, publication_by_ids.size() + records.size());
+    grow_capacity(publication_ids, count);
+    grow_capacity(publication_parent, count);
+    grow_capacity(reference_depth, count);
+    grow_capacity(preorder, count);
+    grow_capacity(preorder_entry, count);
+    grow_capacity(preorder_exit, count);
+    for (auto& level : ancestors) {
+        grow_capacity(level, count);
+    }
+    std::size_t pairs = 0;
+    for (const PublicationRecord& record : records) {
+        std::size_t authors = record.affiliations.size();
+        pairs += authors > 1 ? authors * (authors - 1) / 2 : 0;
+    }
+    grow_capacity(links, links.size() + pairs);
+    grow_capacity(link_by_pair, link_by_pair.size() + pairs);
+
+    // Updating the spanning forest costs a tree walk per connection, for a
+    // batch that can double the graph a rebuild on the next query is cheaper
+    if (pairs > links.size()) {
+        msf_dirty = true;
+    }
+
+    // Year lists are appended to, and each list that got new entries is
+    // sorted once at the end
+    std::vector<AffiliationHandle> touched;
+    unsigned int added = 0;
+    for (const PublicationRecord& record : records) {
+        if (publication_by_ids.find(record.id) != publication_by_ids.end()) {
+            continue;
+        }
+        Publication new_publication = {record.id, record.name, record.year, {}};
+        new_publication.handle = new_publication_handle(record.id);
+        new_publication.by_affiliations.reserve(record.affiliations.size());
+        for (const auto& affid : record.affiliations) {
+            AffiliationHandle handle = intern(affid);
+            new_publication.by_affiliations.push_back(handle);
+            affiliation_publications[handle].push_back(record.id);
+            affiliation_publications_by_year[handle].emplace_back(record.year, record.id);
+            touched.push_back(handle);
+        }
+        auto it = publication_by_ids.emplace(record.id, std::move(new_publication)).first;
+        create_connection(it->second);
+        ++added;
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (AffiliationHandle handle : touched) {
+        // The old entries are a sorted prefix, and so is anything longer
+        // that is_sorted_until finds
+        auto& by_year = affiliation_publications_by_year[handle];
+        auto unsorted = std::is_sorted_until(by_year.begin(), by_year.end());
+        if (unsorted != by_year.end()) {
+            std::sort(unsorted, by_year.end());
+            std::inplace_merge(by_year.begin(), unsorted, by_year.end());
+        }
+    }
+    return added;
+}
+
+namespace
+{
+// Snapshot file layout: a header, a table with the position of each section,
+// then the sections, each aligned so that it can be used in place once the
+// file is mapped. Integers are in native byte order, which the header
+// records so that a file from a different architecture is rejected rather
+// than misread. Version 3 lists every affiliation sharing a coordinate in
+// COORD_OWNERS, where version 2 kept one owner per coordinate.
+char const SNAPSHOT_MAGIC[8] = {'D', 'S', 'S', 'N', 'A', 'P', '\0', '\0'};
+std::uint32_t const SNAPSHOT_VERSION = 3;
+std::uint32_t const SNAPSHOT_BYTE_ORDER = 0x01020304;
+std::size_t const SNAPSHOT_ALIGNMENT = 8;
+
+enum SnapshotSection : std::uint32_t
+{
+    AFFILIATION_FLAGS, AFFILIATION_COORDS,
+    AFFILIATION_ID_OFFSETS, AFFILIATION_ID_CHARS,
+    AFFILIATION_NAME_OFFSETS, AFFILIATION_NAME_CHARS,
+    AFFILIATION_PUBLICATION_OFFSETS, AFFILIATION_PUBLICATIONS,
+    AFFILIATIONS_BY_ID, AFFILIATION_ORDER, COORD_OWNERS,
+    PUBLICATION_IDS, PUBLICATION_PARENTS, PUBLICATION_YEARS,
+    PUBLICATION_NAME_OFFSETS, PUBLICATION_NAME_CHARS,
+    PUBLICATION_AFFILIATION_OFFSETS, PUBLICATION_AFFILIATIONS,
+    PUBLICATION_CHILD_OFFSETS, PUBLICATION_CHILDREN,
+    PUBLICATIONS_BY_ID,
+    LINKS, GRAPH_OFFSETS, GRAPH_NEIGHBOURS, GRAPH_WEIGHTS,
+    FOREST_PARENTS, FOREST_WEIGHTS,
+    SECTION_COUNT
+};
+
+struct SnapshotHeader
+{
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t section_count;
+    std::uint32_t reserved;
+};
+
+struct SnapshotSectionEntry
+{
+    std::uint64_t offset;
+    std::uint64_t count;
+    std::uint64_t element_size;
+};
+
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(std::ostream& output) : output_(output), table_(SECTION_COUNT) {}
+
+    void write_header() {
+        SnapshotHeader header = {};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.byte_order = SNAPSHOT_BYTE_ORDER;
+        header.section_count = SECTION_COUNT;
+        output_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        // The table is filled in by finish() once the positions are known
+        output_.write(reinterpret_cast<char const*>(table_.data()), table_.size() * sizeof(SnapshotSectionEntry));
+        position_ = sizeof(header) + table_.size() * sizeof(SnapshotSectionEntry);
+    }
+    template <typename Type>
+    void write_section(SnapshotSection section, std::vector<Type> const& values) {
+        begin_section(section, sizeof(Type));
+        append(values.data(), values.size());
+    }
+    // Sections can also be written piece by piece with begin_section and append
+    void begin_section(SnapshotSection section, std::size_t element_size) {
+        static char const padding[SNAPSHOT_ALIGNMENT] = {};
+        std::size_t pad = (SNAPSHOT_ALIGNMENT - position_ % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+        output_.write(padding, pad);
+        position_ += pad;
+        current_ = section;
+        table_[section] = {position_, 0, element_size};
+    }
+    template <typename Type>
+    void append(Type const* values, std::size_t count) {
+        static_assert(std::is_trivially_copyable<Type>::value, "only plain values are written as bytes");
+        output_.write(reinterpret_cast<char const*>(values), count * sizeof(Type));
+        position_ += count * sizeof(Type);
+        table_[current_].count += count;
+    }
+    // Writes the texts as an offsets section and a characters section
+    template <typename Getter>
+    void write_texts(SnapshotSection offsets, SnapshotSection chars, std::size_t count, Getter text) {
+        begin_section(offsets, sizeof(std::uint64_t));
+        std::uint64_t offset = 0;
+        append(&offset, 1);
+        for (std::size_t index = 0; index < count; ++index) {
+            offset += text(index).size();
+            append(&offset, 1);
+        }
+        begin_section(chars, sizeof(char));
+        for (std::size_t index = 0; index < count; ++index) {
+            std::string_view value = text(index);
+            append(value.data(), value.size());
+        }
+    }
+    // Writes the lists as an offsets section and a values section
+    template <typename Type, typename Getter>
+    void write_lists(SnapshotSection offsets, SnapshotSection values, std::size_t count, Getter list) {
+        begin_section(offsets, sizeof(std::uint64_t));
+        std::uint64_t offset = 0;
+        append(&offset, 1);
+        for (std::size_t index = 0; index < count; ++index) {
+            offset += list(index).size();
+            append(&offset, 1);
+        }
+        begin_section(values, sizeof(Type));
+        for (std::size_t index = 0; index < count; ++index) {
+            const std::vector<Type>& value = list(index);
+            append(value.data(), value.size());
+        }
+    }
+    bool finish() {
+        output_.seekp(sizeof(SnapshotHeader));
+        output_.write(reinterpret_cast<char const*>(table_.data()), table_.size() * sizeof(SnapshotSectionEntry));
+        output_.flush();
+        return static_cast<bool>(output_);
+    }
+private:
+    std::ostream& output_;
+    std::vector<SnapshotSectionEntry> table_;
+    std::uint64_t position_ = 0;
+    SnapshotSection current_ = AFFILIATION_FLAGS;
+};
+
+// Offsets of a list section: one more than there are items, starting from
+// zero, never decreasing and ending at the number of values
+template <typename View>
+bool valid_offsets(const View& offsets, std::size_t items, std::size_t values)
+{
+    if (offsets.size() != items + 1 || offsets[0] != 0 || offsets.back() != values) {
+        return false;
+    }
+    for (std::size_t index = 0; index < items; ++index) {
+        if (offsets[index + 1] < offsets[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True if following the parent pointers never loops. Each node is walked
+// over once, state 1 marking the walk in progress and 2 a finished node.
+template <typename View>
+bool is_forest(const View& parents, std::uint32_t none)
+{
+    std::vector<std::uint8_t> state(parents.size(), 0);
+    std::vector<std::uint32_t> walk;
+    for (std::uint32_t start = 0; start < parents.size(); ++start) {
+        std::uint32_t current = start;
+        while (current != none && state[current] == 0) {
+            state[current] = 1;
+            walk.push_back(current);
+            current = parents[current];
+        }
+        if (current != none && state[current] == 1) {
+            return false;
+        }
+        for (std::uint32_t node : walk) {
+            state[node] = 2;
+        }
+        walk.clear();
+    }
+    return true;
+}
+}
+
+bool Datastructures::save_snapshot(const std::string& filename)
+{
+    ensure_heap();
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    // The graph and its spanning forest are stored ready to use so that a
+    // mapped snapshot can answer path queries without building anything
+    connection_graph();
+    if (msf_dirty) {
+        rebuild_spanning_forest();
+    }
+
+    SnapshotWriter out(file);
+    out.write_header();
+
+    // Affiliation slots, including ids only referenced by publications and
+    // removed affiliations, so that handles stay valid
+    std::size_t affiliation_count = affiliations.size();
+    std::vector<std::uint8_t> flags(affiliation_count);
+    std::vector<Coord> coords(affiliation_count);
+    std::vector<AffiliationHandle> by_id;
+    by_id.reserve(affiliation_handles.size());
+    for (AffiliationHandle handle = 0; handle < affiliation_count; ++handle) {
+        bool resolves = find_handle(AffiliationID(affiliations.id(handle))) == handle;
+        flags[handle] = (affiliations.exists[handle] ? 1 : 0) | (resolves ? 2 : 0);
+        coords[handle] = affiliations.xy(handle);
+        if (resolves) {
+            by_id.push_back(handle);
+        }
+    }
+    std::sort(by_id.begin(), by_id.end(), [this](AffiliationHandle a, AffiliationHandle b) {
+        return affiliations.id(a) < affiliations.id(b);
+    });
+    out.write_section(AFFILIATION_FLAGS, flags);
+    out.write_section(AFFILIATION_COORDS, coords);
+    out.write_texts(AFFILIATION_ID_OFFSETS, AFFILIATION_ID_CHARS, affiliation_count,
+                    [this](std::size_t handle) { return affiliations.id(handle); });
+    out.write_texts(AFFILIATION_NAME_OFFSETS, AFFILIATION_NAME_CHARS, affiliation_count,
+                    [this](std::size_t handle) { return affiliations.name(handle); });
+    out.write_lists<PublicationID>(AFFILIATION_PUBLICATION_OFFSETS, AFFILIATION_PUBLICATIONS, affiliation_count,
+                    [this](std::size_t handle) -> const std::vector<PublicationID>& { return affiliation_publications[handle]; });
+    out.write_section(AFFILIATIONS_BY_ID, by_id);
+
+    out.write_section(AFFILIATION_ORDER, affiliation_order);
+    std::vector<AffiliationHandle> coord_owners;
+    coord_owners.reserve(affiliation_by_coord.size());
+    for (const auto& [xy, handle] : affiliation_by_coord) {
+        coord_owners.push_back(handle);
+    }
+    out.write_section(COORD_OWNERS, coord_owners);
+
+    // Publications by handle. Slots of removed publications are empty.
+    std::size_t publication_count = publication_ids.size();
+    std::vector<const Publication*> by_handle(publication_count, nullptr);
+    std::vector<Year> years(publication_count, NO_YEAR);
+    std::vector<PublicationHandle> publications_by_id;
+    publications_by_id.reserve(publication_by_ids.size());
+    for (const auto& [id, publication] : publication_by_ids) {
+        by_handle[publication.handle] = &publication;
+        years[publication.handle] = publication.year;
+        publications_by_id.push_back(publication.handle);
+    }
+    std::sort(publications_by_id.begin(), publications_by_id.end(), [this](PublicationHandle a, PublicationHandle b) {
+        return publication_ids[a] < publication_ids[b];
+    });
+    static const Publication removed = {};
+    auto publication_at = [&by_handle](std::size_t handle) -> const Publication& {
+        return by_handle[handle] ? *by_handle[handle] : removed;
+    };
+    out.write_section(PUBLICATION_IDS, publication_ids);
+    out.write_section(PUBLICATION_PARENTS, publication_parent);
+    out.write_section(PUBLICATION_YEARS, years);
+    out.write_texts(PUBLICATION_NAME_OFFSETS, PUBLICATION_NAME_CHARS, publication_count,
+                    [&publication_at](std::size_t handle) -> const std::string& { return publication_at(handle).name; });
+    out.write_lists<AffiliationHandle>(PUBLICATION_AFFILIATION_OFFSETS, PUBLICATION_AFFILIATIONS, publication_count,
+                    [&publication_at](std::size_t handle) -> const std::vector<AffiliationHandle>& { return publication_at(handle).by_affiliations; });
+    out.write_lists<PublicationID>(PUBLICATION_CHILD_OFFSETS, PUBLICATION_CHILDREN, publication_count,
+                    [&publication_at](std::size_t handle) -> const std::vector<PublicationID>& { return publication_at(handle).children; });
+    out.write_section(PUBLICATIONS_BY_ID, publications_by_id);
+
+    out.write_section(LINKS, links);
+    out.write_section(GRAPH_OFFSETS, csr.offsets);
+    out.write_section(GRAPH_NEIGHBOURS, csr.neighbours);
+    out.write_section(GRAPH_WEIGHTS, csr.weights);
+    out.write_section(FOREST_PARENTS, msf_parent);
+    out.write_section(FOREST_WEIGHTS, msf_weight);
+    return out.finish();
+}
+
+bool Datastructures::load_snapshot(const std::string& filename)
+{
+    if (!map_snapshot(filename)) {
+        return false;
+    }
+    materialize_snapshot();
+    return true;
+}
+
+bool Datastructures::map_snapshot(const std::string& filename)
+{
+    // The file is validated before anything is cleared, so a failed load
+    // leaves the current contents as they were
+    MappedSnapshot opened;
+    if (!open_snapshot(filename, opened)) {
+        return false;
+    }
+    clear_all();
+    mapped = std::move(opened);
+    return true;
+}
+
+bool Datastructures::open_snapshot(const std::string& filename, MappedSnapshot& snapshot)
+{
+#ifdef _WIN32
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    snapshot.buffer.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (snapshot.buffer.empty() || !file.read(snapshot.buffer.data(), snapshot.buffer.size())) {
+        snapshot.buffer.clear();
+        return false;
+    }
+    snapshot.base = snapshot.buffer.data();
+    snapshot.length = snapshot.buffer.size();
+#else
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(descriptor, &info) != 0 || info.st_size <= 0) {
+        ::close(descriptor);
+        return false;
+    }
+    void* address = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    snapshot.base = static_cast<const char*>(address);
+    snapshot.length = static_cast<std::size_t>(info.st_size);
+#endif
+
+    const char* base = snapshot.base;
+    std::size_t length = snapshot.length;
+    auto fail = [&snapshot]() {
+        release_snapshot(snapshot);
+        return false;
+    };
+    SnapshotHeader header;
+    std::size_t table_end = sizeof(header) + SECTION_COUNT * sizeof(SnapshotSectionEntry);
+    if (length < table_end) {
+        return fail();
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.byte_order != SNAPSHOT_BYTE_ORDER || header.section_count != SECTION_COUNT) {
+        return fail();
+    }
+    auto map_section = [base, length, table_end](auto& view, SnapshotSection section) {
+        using Type = std::remove_const_t<std::remove_pointer_t<decltype(view.data)>>;
+        SnapshotSectionEntry entry;
+        std::memcpy(&entry, base + sizeof(SnapshotHeader) + section * sizeof(entry), sizeof(entry));
+        if (entry.element_size != sizeof(Type) || entry.offset < table_end || entry.offset % alignof(Type) != 0 ||
+            entry.offset > length || entry.count > (length - entry.offset) / sizeof(Type)) {
+            return false;
+        }
+        view = {reinterpret_cast<const Type*>(base + entry.offset), static_cast<std::size_t>(entry.count)};
+        return true;
+    };
+    MappedSnapshot& s = snapshot;
+    if (!map_section(s.affiliation_flags, AFFILIATION_FLAGS) || !map_section(s.affiliation_coords, AFFILIATION_COORDS) ||
+        !map_section(s.affiliation_id_offsets, AFFILIATION_ID_OFFSETS) || !map_section(s.affiliation_id_chars, AFFILIATION_ID_CHARS) ||
+        !map_section(s.affiliation_name_offsets, AFFILIATION_NAME_OFFSETS) || !map_section(s.affiliation_name_chars, AFFILIATION_NAME_CHARS) ||
+        !map_section(s.affiliation_publication_offsets, AFFILIATION_PUBLICATION_OFFSETS) ||
+        !map_section(s.affiliation_publications, AFFILIATION_PUBLICATIONS) ||
+        !map_section(s.affiliations_by_id, AFFILIATIONS_BY_ID) || !map_section(s.affiliation_order, AFFILIATION_ORDER) ||
+        !map_section(s.coord_owners, COORD_OWNERS) ||
+        !map_section(s.publication_ids, PUBLICATION_IDS) || !map_section(s.publication_parents, PUBLICATION_PARENTS) ||
+        !map_section(s.publication_years, PUBLICATION_YEARS) ||
+        !map_section(s.publication_name_offsets, PUBLICATION_NAME_OFFSETS) || !map_section(s.publication_name_chars, PUBLICATION_NAME_CHARS) ||
+        !map_section(s.publication_affiliation_offsets, PUBLICATION_AFFILIATION_OFFSETS) ||
+        !map_section(s.publication_affiliations, PUBLICATION_AFFILIATIONS) ||
+        !map_section(s.publication_child_offsets, PUBLICATION_CHILD_OFFSETS) || !map_section(s.publication_children, PUBLICATION_CHILDREN) ||
+        !map_section(s.publications_by_id, PUBLICATIONS_BY_ID) ||
+        !map_section(s.links, LINKS) || !map_section(s.graph_offsets, GRAPH_OFFSETS) ||
+        !map_section(s.graph_neighbours, GRAPH_NEIGHBOURS) || !map_section(s.graph_weights, GRAPH_WEIGHTS) ||
+        !map_section(s.forest_parents, FOREST_PARENTS) || !map_section(s.forest_weights, FOREST_WEIGHTS)) {
+        return fail();
+    }
+
+    // Affiliations
+    std::size_t affiliation_count = s.affiliation_flags.size();
+    if (affiliation_count >= NO_HANDLE || s.affiliation_coords.size() != affiliation_count ||
+        !valid_offsets(s.affiliation_id_offsets, affiliation_count, s.affiliation_id_chars.size()) ||
+        !valid_offsets(s.affiliation_name_offsets, affiliation_count, s.affiliation_name_chars.size()) ||
+        !valid_offsets(s.affiliation_publication_offsets, affiliation_count, s.affiliation_publications.size())) {
+        return fail();
+    }
+    std::size_t resolving = 0;
+    for (AffiliationHandle handle = 0; handle < affiliation_count; ++handle) {
+        std::uint8_t flags = s.affiliation_flags[handle];
+        // An existing affiliation is always found by its id
+        if (flags > 3 || flags == 1) {
+            return fail();
+        }
+        resolving += (flags & 2) != 0;
+        if (flags & 1) {
+            s.extent.extend(s.affiliation_coords[handle]);
+        }
+    }
+    if (s.affiliations_by_id.size() != resolving) {
+        return fail();
+    }
+    for (std::size_t index = 0; index < s.affiliations_by_id.size(); ++index) {
+        AffiliationHandle handle = s.affiliations_by_id[index];
+        if (handle >= affiliation_count || !(s.affiliation_flags[handle] & 2) ||
+            (index > 0 && !(s.affiliation_id(s.affiliations_by_id[index - 1]) < s.affiliation_id(handle)))) {
+            return fail();
+        }
+    }
+    for (AffiliationHandle handle : s.affiliation_order) {
+        if (handle >= affiliation_count || !(s.affiliation_flags[handle] & 1)) {
+            return fail();
+        }
+    }
+    for (AffiliationHandle handle : s.coord_owners) {
+        if (handle >= affiliation_count || !(s.affiliation_flags[handle] & 1)) {
+            return fail();
+        }
+    }
+
+    // Publications and the reference forest
+    std::size_t publication_count = s.publication_ids.size();
+    if (publication_count >= NO_HANDLE || s.publication_parents.size() != publication_count ||
+        s.publication_years.size() != publication_count ||
+        !valid_offsets(s.publication_name_offsets, publication_count, s.publication_name_chars.size()) ||
+        !valid_offsets(s.publication_affiliation_offsets, publication_count, s.publication_affiliations.size()) ||
+        !valid_offsets(s.publication_child_offsets, publication_count, s.publication_children.size())) {
+        return fail();
+    }
+    std::size_t live = 0;
+    std::size_t child_count = 0;
+    for (PublicationHandle handle = 0; handle < publication_count; ++handle) {
+        PublicationHandle parent = s.publication_parents[handle];
+        bool removed = s.publication_ids[handle] == NO_PUBLICATION;
+        if (parent != NO_HANDLE &&
+            (removed || parent >= publication_count || s.publication_ids[parent] == NO_PUBLICATION)) {
+            return fail();
+        }
+        live += !removed;
+        child_count += parent != NO_HANDLE;
+    }
+    if (s.publications_by_id.size() != live) {
+        return fail();
+    }
+    for (std::size_t index = 0; index < s.publications_by_id.size(); ++index) {
+        PublicationHandle handle = s.publications_by_id[index];
+        if (handle >= publication_count || s.publication_ids[handle] == NO_PUBLICATION ||
+            (index > 0 && s.publication_ids[s.publications_by_id[index - 1]] >= s.publication_ids[handle])) {
+            return fail();
+        }
+    }
+    for (AffiliationHandle handle : s.publication_affiliations) {
+        if (handle >= affiliation_count) {
+            return fail();
+        }
+    }
+    for (PublicationID id : s.affiliation_publications) {
+        if (s.find_publication(id) == NO_HANDLE) {
+            return fail();
+        }
+    }
+    // The children lists must be the parent table seen from the other side,
+    // each child listed once
+    std::vector<bool> listed(publication_count, false);
+    for (PublicationHandle handle = 0; handle < publication_count; ++handle) {
+        for (PublicationID child : MappedSnapshot::slice(s.publication_child_offsets, s.publication_children, handle)) {
+            PublicationHandle child_handle = s.find_publication(child);
+            if (child_handle == NO_HANDLE || s.publication_parents[child_handle] != handle || listed[child_handle]) {
+                return fail();
+            }
+            listed[child_handle] = true;
+            --child_count;
+        }
+    }
+    if (child_count != 0 || !is_forest(s.publication_parents, NO_HANDLE)) {
+        return fail();
+    }
+
+    // Connections, their adjacency arrays and the maximum spanning forest
+    std::unordered_set<std::uint64_t> pairs;
+    pairs.reserve(s.links.size());
+    for (const Link& link : s.links) {
+        if (link.aff1 >= affiliation_count || link.aff2 >= affiliation_count || link.aff1 == link.aff2 ||
+            !pairs.insert(link_key(link.aff1, link.aff2)).second) {
+            return fail();
+        }
+    }
+    if (s.graph_neighbours.size() != s.graph_weights.size() ||
+        !valid_offsets(s.graph_offsets, affiliation_count, s.graph_neighbours.size())) {
+        return fail();
+    }
+    for (AffiliationHandle handle : s.graph_neighbours) {
+        if (handle >= affiliation_count) {
+            return fail();
+        }
+    }
+    if (s.forest_parents.size() != affiliation_count || s.forest_weights.size() != affiliation_count) {
+        return fail();
+    }
+    for (AffiliationHandle handle : s.forest_parents) {
+        if (handle != NO_HANDLE && handle >= affiliation_count) {
+            return fail();
+        }
+    }
+    if (!is_forest(s.forest_parents, NO_HANDLE)) {
+        return fail();
+    }
+    return true;
+}
+
+void Datastructures::release_snapshot(MappedSnapshot& snapshot)
+{
+#ifndef _WIN32
+    if (snapshot.active() && snapshot.buffer.empty()) {
+        ::munmap(const_cast<char*>(snapshot.base), snapshot.length);
+    }
+#endif
+    snapshot = MappedSnapshot();
+}
+
+void Datastructures::materialize_snapshot()
+{
+    const MappedSnapshot& s = mapped;
+
+    // Affiliation slots and the indexes derived from them
+    std::size_t affiliation_count = s.affiliation_flags.size();
+    affiliations.reserve(affiliation_count);
+    affiliation_publications.resize(affiliation_count);
+    affiliation_publications_by_year.resize(affiliation_count);
+    affiliation_handles.reserve(s.affiliations_by_id.size());
+    for (AffiliationHandle handle = 0; handle < affiliation_count; ++handle) {
+        affiliations.append(s.affiliation_id(handle));
+        if (s.affiliation_flags[handle] & 2) {
+            affiliation_handles.emplace(s.affiliation_id(handle), handle);
+        }
+        if (s.affiliation_flags[handle] & 1) {
+            affiliations.exists[handle] = 1;
+            affiliations.set_name(handle, s.affiliation_name(handle));
+            affiliations.set_xy(handle, s.affiliation_coords[handle]);
+            affiliations_by_name.insert(handle);
+            affiliations_by_distance.insert({affiliations.distances[handle], affiliations.ys[handle], handle});
+        } else {
+            affiliations.xs[handle] = s.affiliation_coords[handle].x;
+            affiliations.ys[handle] = s.affiliation_coords[handle].y;
+        }
+        auto publications = MappedSnapshot::slice(s.affiliation_publication_offsets, s.affiliation_publications, handle);
+        affiliation_publications[handle].assign(publications.begin(), publications.end());
+        auto& by_year = affiliation_publications_by_year[handle];
+        by_year.reserve(publications.size());
+        for (PublicationID id : publications) {
+            by_year.emplace_back(s.publication_years[s.find_publication(id)], id);
+        }
+        std::sort(by_year.begin(), by_year.end());
+    }
+    affiliation_order.assign(s.affiliation_order.begin(), s.affiliation_order.end());
+    // Every affiliation sharing a coordinate is listed, as in the multimap
+    for (AffiliationHandle handle : s.coord_owners) {
+        affiliation_by_coord.emplace(affiliations.xy(handle), handle);
+    }
+
+    // Publications
+    publication_ids.assign(s.publication_ids.begin(), s.publication_ids.end());
+    publication_parent.assign(s.publication_parents.begin(), s.publication_parents.end());
+    publication_by_ids.reserve(s.publications_by_id.size());
+    for (PublicationHandle handle : s.publications_by_id) {
+        Publication publication;
+        publication.id = s.publication_ids[handle];
+        publication.name = Name(s.publication_name(handle));
+        publication.year = s.publication_years[handle];
+        auto by_affiliations = MappedSnapshot::slice(s.publication_affiliation_offsets, s.publication_affiliations, handle);
+        publication.by_affiliations.assign(by_affiliations.begin(), by_affiliations.end());
+        PublicationHandle parent = s.publication_parents[handle];
+        publication.parent = parent != NO_HANDLE ? s.publication_ids[parent] : NO_PUBLICATION;
+        auto children = MappedSnapshot::slice(s.publication_child_offsets, s.publication_children, handle);
+        publication.children.assign(children.begin(), children.end());
+        publication.handle = handle;
+        publication_by_ids.emplace(publication.id, std::move(publication));
+    }
+
+    // Links are never removed one by one, so each adjacency list is its
+    // links in creation order
+    links.assign(s.links.begin(), s.links.end());
+    connection_by_handle.resize(affiliation_count);
+    link_by_pair.reserve(links.size());
+    for (LinkIndex index = 0; index < links.size(); ++index) {
+        const Link& link = links[index];
+        link_by_pair.emplace(link_key(link.aff1, link.aff2), index);
+        connection_by_handle[link.aff1].push_back(index);
+        connection_by_handle[link.aff2].push_back(index);
+    }
+    csr.offsets.assign(s.graph_offsets.begin(), s.graph_offsets.end());
+    csr.neighbours.assign(s.graph_neighbours.begin(), s.graph_neighbours.end());
+    csr.weights.assign(s.graph_weights.begin(), s.graph_weights.end());
+    csr_dirty = false;
+    msf_parent.assign(s.forest_parents.begin(), s.forest_parents.end());
+    msf_weight.assign(s.forest_weights.begin(), s.forest_weights.end());
+    msf_dirty = false;
+
+    // The reference indexes are rebuilt lazily
+    std::size_t publication_count = publication_ids.size();
+    reference_depth.assign(publication_count, 0);
+    ancestors.assign(1, std::vector<PublicationHandle>(publication_count));
+    ancestors_dirty = true;
+    preorder.clear();
+    preorder_entry.assign(publication_count, 0);
+    preorder_exit.assign(publication_count, 0);
+    preorder_dirty = true;
+
+    release_snapshot(mapped);
+}
+
+namespace
+{
+// Heap use of the standard containers as libstdc++ lays them out on a 64 bit
+// glibc system. Each allocation takes a malloc chunk: the request plus an 8
+// byte header rounded up to 16 bytes, 32 bytes at least. Tree nodes carry
+// colour and three links before the value, hash nodes a next pointer and
+// (assumed here) the cached hash code.
+std::size_t const TREE_NODE_LINKS = 32;
+std::size_t const HASH_NODE_LINKS = 2 * sizeof(void*);
+// Longest string kept inside the string object itself
+std::size_t const SHORT_STRING_CAPACITY = 15;
+
+void add_allocation(MemoryUsage& usage, std::size_t size)
+{
+    if (size > 0) {
+        usage.bytes += std::max<std::size_t>(32, (size + 8 + 15) / 16 * 16);
+        ++usage.allocations;
+    }
+}
+
+void add_string(MemoryUsage& usage, const std::string& text)
+{
+    if (text.capacity() > SHORT_STRING_CAPACITY) {
+        add_allocation(usage, text.capacity() + 1);
+    }
+}
+
+// Contents callback for elements that own no memory of their own
+struct NoContents {
+    template <typename Type>
+    void operator()(MemoryUsage&, const Type&) const {}
+};
+
+template <typename Type, typename Contents = NoContents>
+void add_vector(MemoryUsage& usage, const std::vector<Type>& values, Contents contents = {})
+{
+    usage.bytes += sizeof(values);
+    add_allocation(usage, values.capacity() * sizeof(Type));
+    for (const auto& value : values) {
+        contents(usage, value);
+    }
+}
+
+// std::set and std::map
+template <typename Tree, typename Contents = NoContents>
+void add_tree(MemoryUsage& usage, const Tree& tree, Contents contents = {})
+{
+    usage.bytes += sizeof(tree);
+    for (const auto& value : tree) {
+        add_allocation(usage, TREE_NODE_LINKS + sizeof(value));
+        contents(usage, value);
+    }
+}
+
+// std::unordered_set and std::unordered_map, a single bucket lives inside the object
+template <typename Table, typename Contents = NoContents>
+void add_hash_table(MemoryUsage& usage, const Table& table, Contents contents = {})
+{
+    usage.bytes += sizeof(table);
+    if (table.bucket_count() > 1) {
+        add_allocation(usage, table.bucket_count() * sizeof(void*));
+    }
+    for (const auto& value : table) {
+        add_allocation(usage, HASH_NODE_LINKS + sizeof(value));
+        contents(usage, value);
+    }
+}
+
+// Vector of vectors, such as per affiliation adjacency lists
+template <typename Type>
+void add_nested_vector(MemoryUsage& usage, const std::vector<std::vector<Type>>& lists)
+{
+    add_vector(usage, lists, [](MemoryUsage& total, const std::vector<Type>& list) {
+        add_allocation(total, list.capacity() * sizeof(Type));
+    });
+}
+}
+
+std::vector<MemoryUsage> Datastructures::memory_usage()
+{
+    auto add_publication = [](MemoryUsage& usage, const Publication& publication) {
+        add_string(usage, publication.name);
+        add_allocation(usage, publication.by_affiliations.capacity() * sizeof(AffiliationHandle));
+        add_allocation(usage, publication.children.capacity() * sizeof(PublicationID));
+    };
+    auto add_search_state = [](MemoryUsage& usage, const SearchState& state) {
+        add_vector(usage, state.stamp);
+        add_vector(usage, state.parent);
+        add_vector(usage, state.parent_edge);
+        add_vector(usage, state.depth);
+        add_vector(usage, state.cost);
+        add_vector(usage, state.closed);
+    };
+
+    std::vector<MemoryUsage> rows;
+    auto row = [&rows](const char* container, std::size_t elements) -> MemoryUsage& {
+        rows.push_back({container, elements});
+        return rows.back();
+    };
+
+    if (mapped.active()) {
+        // File pages are shared through the page cache, the copy in buffer isn't
+        MemoryUsage& usage = row("mapped snapshot", mapped.affiliation_order.size());
+        usage.bytes = sizeof(mapped) + mapped.length;
+        usage.allocations = mapped.buffer.empty() ? 0 : 1;
+    }
+
+    add_hash_table(row("affiliation_handles", affiliation_handles.size()), affiliation_handles,
+                   [](MemoryUsage& usage, const auto& entry) { add_string(usage, entry.first); });
+    MemoryUsage& table = row("affiliations", affiliations.size());
+    add_vector(table, affiliations.xs);
+    add_vector(table, affiliations.ys);
+    add_vector(table, affiliations.distances);
+    add_vector(table, affiliations.exists);
+    add_vector(table, affiliations.id_offsets);
+    add_vector(table, affiliations.id_chars);
+    add_vector(table, affiliations.name_offsets);
+    add_vector(table, affiliations.name_lengths);
+    add_vector(table, affiliations.name_chars);
+    add_vector(row("affiliation_order", affiliation_order.size()), affiliation_order);
+    add_tree(row("affiliations_by_name", affiliations_by_name.size()), affiliations_by_name);
+    add_tree(row("affiliations_by_distance", affiliations_by_distance.size()), affiliations_by_distance);
+    add_hash_table(row("affiliation_by_coord", affiliation_by_coord.size()), affiliation_by_coord);
+
+    MemoryUsage& cells = row("grid", grid.count);
+    cells.bytes += sizeof(grid) - sizeof(grid.cells);
+    add_hash_table(cells, grid.cells, [](MemoryUsage& usage, const auto& cell) {
+        add_allocation(usage, cell.second.capacity() * sizeof(AffiliationHandle));
+    });
+
+    add_hash_table(row("publication_by_ids", publication_by_ids.size()), publication_by_ids,
+                   [&add_publication](MemoryUsage& usage, const auto& entry) { add_publication(usage, entry.second); });
+    add_vector(row("all_Publications", all_Publications.size()), all_Publications, add_publication);
+    add_nested_vector(row("affiliation_publications", affiliation_publications.size()), affiliation_publications);
+    add_nested_vector(row("affiliation_publications_by_year", affiliation_publications_by_year.size()),
+                      affiliation_publications_by_year);
+
+    MemoryUsage& forest = row("publication_ids, publication_parent", publication_ids.size());
+    add_vector(forest, publication_ids);
+    add_vector(forest, publication_parent);
+    MemoryUsage& lifting = row("ancestors, reference_depth", publication_ids.size());
+    add_nested_vector(lifting, ancestors);
+    add_vector(lifting, reference_depth);
+    MemoryUsage& order = row("preorder", preorder.size());
+    add_vector(order, preorder);
+    add_vector(order, preorder_entry);
+    add_vector(order, preorder_exit);
+
+    add_vector(row("links", links.size()), links);
+    add_nested_vector(row("connection_by_handle", connection_by_handle.size()), connection_by_handle);
+    add_hash_table(row("link_by_pair", link_by_pair.size()), link_by_pair);
+    MemoryUsage& graph = row("csr", csr.neighbours.size());
+    add_vector(graph, csr.offsets);
+    add_vector(graph, csr.neighbours);
+    add_vector(graph, csr.weights);
+    MemoryUsage& spanning = row("msf_parent, msf_weight", msf_parent.size());
+    add_vector(spanning, msf_parent);
+    add_vector(spanning, msf_weight);
+
+    MemoryUsage& scratch = row("search scratch", forward_search.stamp.size());
+    add_search_state(scratch, forward_search);
+    add_search_state(scratch, backward_search);
+    add_search_state(scratch, tree_marks);
+    add_vector(scratch, frontier);
+    add_vector(scratch, other_frontier);
+    add_vector(scratch, next_frontier);
+    add_vector(scratch, search_heap);
+    add_vector(scratch, dfs_stack);
+    add_vector(scratch, distance_scratch);
+
+    return rows;
+}
+
+Path Datastructures::bidirectional_bfs(AffiliationHandle source, AffiliationHandle target, Weight min_weight)
+{
+    GraphView graph = connection_graph();
+    std::size_t node_count = graph.offsets.size() - 1;
+    forward_search.begin(node_count);
+    backward_search.begin(node_count);
+    forward_search.visit(source, NO_HANDLE, 0, 0);
+    backward_search.visit(target, NO_HANDLE, 0, 0);
+    frontier.assign(1, source);
+    other_frontier.assign(1, target);
+
+    // frontier always belongs to 'near', other_frontier to 'far'
+    SearchState* near = &forward_search;
+    SearchState* far = &backward_search;
+    AffiliationHandle meet = NO_HANDLE;
+    std::uint32_t best = std::numeric_limits<std::uint32_t>::max();
+
+    while (!frontier.empty() && !other_frontier.empty()) {
+        // Expand the smaller frontier by one whole level
+        if (other_frontier.size() < frontier.size()) {
+            std::swap(frontier, other_frontier);
+            std::swap(near, far);
+        }
+        next_frontier.clear();
+        for (AffiliationHandle current : frontier) {
+            ++last_search_expansions;
+            for (std::uint32_t edge = graph.offsets[current]; edge < graph.offsets[current + 1]; ++edge) {
+                AffiliationHandle next = graph.neighbours[edge];
+                if (near->visited(next) || graph.weights[edge] < min_weight) {
+                    continue;
+                }
+                near->visit(next, current, edge, near->depth[current] + 1);
+                next_frontier.push_back(next);
+                if (far->visited(next) && near->depth[next] + far->depth[next] < best) {
+                    best = near->depth[next] + far->depth[next];
+                    meet = next;
+                }
+            }
+        }
+        if (meet != NO_HANDLE) {
+            break;
+        }
+        std::swap(frontier, next_frontier);
+    }
+
+    Path path;
+    if (meet == NO_HANDLE) {
+        return path;
+    }
+    for (AffiliationHandle current = meet; current != source; current = forward_search.parent[current]) {
+        AffiliationHandle previous = forward_search.parent[current];
+        path.push_back(to_connection(previous, current, graph.weights[forward_search.parent_edge[current]]));
+    }
+    std::reverse(path.begin(), path.end());
+    for (AffiliationHandle current = meet; current != target; current = backward_search.parent[current]) {
+        AffiliationHandle next = backward_search.parent[current];
+        path.push_back(to_connection(current, next, graph.weights[backward_search.parent_edge[current]]));
+    }
+    return path;
+}
+
+PathWithDist Datastructures::shortest_path_search(AffiliationHandle source, AffiliationHandle target)
+{
+    GraphView graph = connection_graph();
+    forward_search.begin(graph.offsets.size() - 1);
+    search_heap.clear();
+    auto heap_order = [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second > b.second;
+    };
+    // Straight line distance never overestimates, so A* finds a path of the
+    // same length as Dijkstra, though not always the same one when several
+    // paths tie
+    auto estimate = [this, target](AffiliationHandle handle) {
+        return shortest_path_heuristic ? coord_distance(handle, target) : 0.0;
+    };
+
+    forward_search.visit(source, NO_HANDLE, 0, 0);
+    forward_search.cost[source] = 0.0;
+    search_heap.push_back({estimate(source), source});
+
+    bool found = false;
+    while (!search_heap.empty()) {
+        std::pop_heap(search_heap.begin(), search_heap.end(), heap_order);
+        AffiliationHandle current = search_heap.back().second;
+        search_heap.pop_back();
+        if (forward_search.is_closed(current)) {
+            continue;
+        }
+        forward_search.close(current);
+        ++last_search_expansions;
+        if (current == target) {
+            found = true;
+            break;
+        }
+
+        for (std::uint32_t edge = graph.offsets[current]; edge < graph.offsets[current + 1]; ++edge) {
+            AffiliationHandle next = graph.neighbours[edge];
+            // Connections of a removed affiliation stay in the graph, but the
+            // path may not route through it
+            if (forward_search.is_closed(next) || !affiliation_exists(next)) {
+                continue;
+            }
+            double cost = forward_search.cost[current] + coord_distance(current, next);
+            if (!forward_search.visited(next) || cost < forward_search.cost[next]) {
+                forward_search.visit(next, current, edge, forward_search.depth[current] + 1);
+                forward_search.cost[next] = cost;
+                search_heap.push_back({cost + estimate(next), next});
+                std::push_heap(search_heap.begin(), search_heap.end(), heap_order);
+            }
+        }
+    }
+
+    PathWithDist path;
+    if (!found) {
+        return path;
+    }
+    for (AffiliationHandle current = target; current != source; current = forward_search.parent[current]) {
+        AffiliationHandle previous = forward_search.parent[current];
+        Connection connection = to_connection(previous, current, graph.weights[forward_search.parent_edge[current]]);
+        path.push_back({connection, static_cast<Distance>(coord_distance(previous, current))});
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+Datastructures::GraphView Datastructures::connection_graph()
+{
+    if (mapped.active()) {
+        return {mapped.graph_offsets, mapped.graph_neighbours, mapped.graph_weights};
+    }
+    if (!csr_dirty) {
+        return {view_of(csr.offsets), view_of(csr.neighbours), view_of(csr.weights)};
+    }
+
+    std::size_t node_count = connection_by_handle.size();
+    csr.offsets.assign(node_count + 1, 0);
+    for (std::size_t handle = 0; handle < node_count; ++handle) {
+        csr.offsets[handle + 1] = csr.offsets[handle] + connection_by_handle[handle].size();
+    }
+    csr.neighbours.resize(csr.offsets[node_count]);
+    csr.weights.resize(csr.offsets[node_count]);
+    for (std::size_t handle = 0; handle < node_count; ++handle) {
+        std::uint32_t edge = csr.offsets[handle];
+        for (LinkIndex index : connection_by_handle[handle]) {
+            const Link& link = links[index];
+            csr.neighbours[edge] = link_other(link, handle);
+            csr.weights[edge] = link.weight;
+            ++edge;
+        }
+    }
+    csr_dirty = false;
+    return {view_of(csr.offsets), view_of(csr.neighbours), view_of(csr.weights)};
+}
+
+void Datastructures::rebuild_spanning_forest()
+{
+    std::size_t node_count = affiliations.size();
+
+    // Kruskal over the connections, heaviest first
+    std::vector<LinkIndex> order(links.size());
+    for (LinkIndex index = 0; index < order.size(); ++index) {
+        order[index] = index;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](LinkIndex a, LinkIndex b) {
+        return links[a].weight > links[b].weight;
+    });
+    std::vector<AffiliationHandle> component(node_count);
+    for (std::size_t handle = 0; handle < node_count; ++handle) {
+        component[handle] = handle;
+    }
+    auto find_component = [&component](AffiliationHandle handle) {
+        while (component[handle] != handle) {
+            component[handle] = component[component[handle]];
+            handle = component[handle];
+        }
+        return handle;
+    };
+    std::vector<std::vector<LinkIndex>> tree_links(node_count);
+    for (LinkIndex index : order) {
+        const Link& link = links[index];
+        AffiliationHandle first = find_component(link.aff1);
+        AffiliationHandle second = find_component(link.aff2);
+        if (first != second) {
+            component[first] = second;
+            tree_links[link.aff1].push_back(index);
+            tree_links[link.aff2].push_back(index);
+        }
+    }
+
+    // Orient each tree by walking it from an arbitrary root
+    msf_parent.assign(node_count, NO_HANDLE);
+    msf_weight.assign(node_count, NO_WEIGHT);
+    tree_marks.begin(node_count);
+    std::vector<AffiliationHandle> stack;
+    for (AffiliationHandle root = 0; root < node_count; ++root) {
+        if (tree_marks.visited(root)) {
+            continue;
+        }
+        tree_marks.visit(root, NO_HANDLE, 0, 0);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            AffiliationHandle current = stack.back();
+            stack.pop_back();
+            for (LinkIndex index : tree_links[current]) {
+                const Link& link = links[index];
+                AffiliationHandle next = link_other(link, current);
+                if (!tree_marks.visited(next)) {
+                    tree_marks.visit(next, current, 0, 0);
+                    msf_parent[next] = current;
+                    msf_weight[next] = link.weight;
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+    msf_dirty = false;
+}
+
+bool Datastructures::spanning_path_minimum(AffiliationHandle first, AffiliationHandle second, Weight& minimum, AffiliationHandle& minimum_child)
+{
+    // A mapped snapshot carries its own forest
+    ArrayView<AffiliationHandle> parent = mapped.active() ? mapped.forest_parents : view_of(msf_parent);
+    ArrayView<Weight> weight = mapped.active() ? mapped.forest_weights : view_of(msf_weight);
+    tree_marks.begin(parent.size());
+    for (AffiliationHandle current = first; current != NO_HANDLE; current = parent[current]) {
+        tree_marks.visit(current, NO_HANDLE, 0, 0);
+    }
+    AffiliationHandle ancestor = second;
+    while (ancestor != NO_HANDLE && !tree_marks.visited(ancestor)) {
+        ancestor = parent[ancestor];
+    }
+    if (ancestor == NO_HANDLE) {
+        return false;
+    }
+
+    minimum = std::numeric_limits<Weight>::max();
+    minimum_child = NO_HANDLE;
+    for (AffiliationHandle start : {first, second}) {
+        for (AffiliationHandle current = start; current != ancestor; current = parent[current]) {
+            if (weight[current] < minimum) {
+                minimum = weight[current];
+                minimum_child = current;
+            }
+        }
+    }
+    return true;
+}
+
+void Datastructures::reroot_spanning_tree(AffiliationHandle handle)
+{
+    AffiliationHandle previous = NO_HANDLE;
+    Weight previous_weight = NO_WEIGHT;
+    AffiliationHandle current = handle;
+    while (current != NO_HANDLE) {
+        AffiliationHandle next = msf_parent[current];
+        Weight weight = msf_weight[current];
+        msf_parent[current] = previous;
+        msf_weight[current] = previous_weight;
+        previous = current;
+        previous_weight = weight;
+        current = next;
+    }
+}
+
+void Datastructures::update_spanning_forest(AffiliationHandle first, AffiliationHandle second, Weight weight)
+{
+    // A heavier tree edge keeps the forest maximal
+    if (msf_parent[first] == second) {
+        msf_weight[first] = weight;
+        return;
+    }
+    if (msf_parent[second] == first) {
+        msf_weight[second] = weight;
+        return;
+    }
+
+    Weight minimum = NO_WEIGHT;
+    AffiliationHandle minimum_child = NO_HANDLE;
+    if (spanning_path_minimum(first, second, minimum, minimum_child)) {
+        if (weight <= minimum) {
+            return;
+        }
+        // Swap the lightest edge on the cycle for the new one. After the cut,
+        // minimum_child roots the part containing one of the endpoints.
+        msf_parent[minimum_child] = NO_HANDLE;
+        msf_weight[minimum_child] = NO_WEIGHT;
+        AffiliationHandle root = first;
+        while (msf_parent[root] != NO_HANDLE) {
+            root = msf_parent[root];
+        }
+        if (root != minimum_child) {
+            std::swap(first, second);
+        }
+    }
+    // Hang the tree of 'first' below 'second'
+    reroot_spanning_tree(first);
+    msf_parent[first] = second;
+    msf_weight[first] = weight;
+}
+
+void Datastructures::rebuild_grid()
+{
+    grid = SpatialGrid();
+    long long min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+    std::size_t count = 0;
+    for (AffiliationHandle handle = 0; handle < affiliations.size(); ++handle) {
+        if (!affiliations.exists[handle]) {
+            continue;
+        }
+        int x = affiliations.xs[handle];
+        int y = affiliations.ys[handle];
+        if (count == 0 || x < min_x) { min_x = x; }
+        if (count == 0 || x > max_x) { max_x = x; }
+        if (count == 0 || y < min_y) { min_y = y; }
+        if (count == 0 || y > max_y) { max_y = y; }
+        ++count;
+    }
+
+    // Aim for about two affiliations per cell if they are spread evenly
+    double area = static_cast<double>(max_x - min_x + 1) * static_cast<double>(max_y - min_y + 1);
+    double side = std::sqrt(2.0 * area / std::max<std::size_t>(count, 1));
+    grid.cell_size = static_cast<int>(std::min(side, static_cast<double>(std::numeric_limits<int>::max() / 2)));
+    grid.cell_size = std::max(grid.cell_size, 1);
+    grid.built_count = count;
+    grid.cells.reserve(count);
+    for (AffiliationHandle handle = 0; handle < affiliations.size(); ++handle) {
+        if (affiliations.exists[handle]) {
+            grid_insert(handle);
+        }
+    }
+}
+
+void Datastructures::grid_insert(AffiliationHandle handle)
+{
+    if (grid.cell_size == 0) {
+        return;
+    }
+    int cell_x = grid_cell(affiliations.xs[handle]);
+    int cell_y = grid_cell(affiliations.ys[handle]);
+    grid.cells[grid_key(cell_x, cell_y)].push_back(handle);
+    if (grid.count == 0 && grid.max_x < grid.min_x) {
+        grid.min_x = grid.max_x = cell_x;
+        grid.min_y = grid.max_y = cell_y;
+    } else {
+        grid.min_x = std::min(grid.min_x, cell_x);
+        grid.max_x = std::max(grid.max_x, cell_x);
+        grid.min_y = std::min(grid.min_y, cell_y);
+        grid.max_y = std::max(grid.max_y, cell_y);
+    }
+    ++grid.count;
+}
+
+void Datastructures::grid_erase(AffiliationHandle handle)
+{
+    if (grid.cell_size == 0) {
+        return;
+    }
+    auto cell = grid.cells.find(grid_key(grid_cell(affiliations.xs[handle]), grid_cell(affiliations.ys[handle])));
+    if (cell == grid.cells.end()) {
+        return;
+    }
+    std::vector<AffiliationHandle>& handles = cell->second;
+    auto it = std::find(handles.begin(), handles.end(), handle);
+    if (it != handles.end()) {
+        *it = handles.back();
+        handles.pop_back();
+        --grid.count;
+        if (handles.empty()) {
+            grid.cells.erase(cell);
+        }
+    }
+}
+
+void Datastructures::ensure_grid()
+{
+    // The cell bounds are ints, but their difference may not fit one
+    long long box_width = static_cast<long long>(grid.max_x) - grid.min_x + 1;
+    long long box_height = static_cast<long long>(grid.max_y) - grid.min_y + 1;
+    double box_cells = static_cast<double>(box_width) * static_cast<double>(box_height);
+    // Rebuild when the cell size no longer fits the data: the count has
+    // changed a lot, or the coordinates have spread over far more cells
+    if (grid.cell_size == 0 || grid.count > 2 * grid.built_count + 16 || 2 * grid.count + 16 < grid.built_count
+        || box_cells > 8.0 * std::max(grid.count, grid.built_count) + 64) {
+        rebuild_grid();
+    }
+}
+
+std::vector<AffiliationHandle> Datastructures::grid_nearest(Coord xy, std::size_t k)
+{
+    ensure_grid();
+
+    // Candidates sorted by (squared distance, y, id), at most k of them
+    std::vector<std::pair<long long, AffiliationHandle>> best;
+    auto closer = [this](const std::pair<long long, AffiliationHandle>& a, const std::pair<long long, AffiliationHandle>& b) {
+        return nearer(a, b);
+    };
+    auto scan_cell = [&](long long cell_x, long long cell_y) {
+        auto cell = grid.cells.find(grid_key(cell_x, cell_y));
+        if (cell == grid.cells.end()) {
+            return;
+        }
+        for (AffiliationHandle handle : cell->second) {
+            long long dx = static_cast<long long>(affiliations.xs[handle]) - xy.x;
+            long long dy = static_cast<long long>(affiliations.ys[handle]) - xy.y;
+            std::pair<long long, AffiliationHandle> candidate{dx * dx + dy * dy, handle};
+            if (best.size() == k && !closer(candidate, best.back())) {
+                continue;
+            }
+            best.insert(std::upper_bound(best.begin(), best.end(), candidate, closer), candidate);
+            if (best.size() > k) {
+                best.pop_back();
+            }
+        }
+    };
+
+    if (k > 0 && grid.count > 0) {
+        long long size = grid.cell_size;
+        long long query_x = grid_cell(xy.x);
+        long long query_y = grid_cell(xy.y);
+        // Distance from xy to the nearest edge of its own cell; every point
+        // in ring r is at least (r-1)*size + 1 + margin away along some axis
+        long long margin = std::min({xy.x - query_x * size, (query_x + 1) * size - 1 - xy.x,
+                                     xy.y - query_y * size, (query_y + 1) * size - 1 - xy.y});
+        // Rings that don't reach the bounding box are skipped entirely
+        long long first_ring = std::max({0LL, grid.min_x - query_x, query_x - grid.max_x,
+                                         grid.min_y - query_y, query_y - grid.max_y});
+        long long last_ring = std::max({std::abs(query_x - grid.min_x), std::abs(query_x - grid.max_x),
+                                        std::abs(query_y - grid.min_y), std::abs(query_y - grid.max_y)});
+        for (long long ring = first_ring; ring <= last_ring; ++ring) {
+            if (best.size() == k && ring > 0) {
+                long long bound = (ring - 1) * size + 1 + margin;
+                if (bound * bound > best.back().first) {
+                    break;
+                }
+            }
+            if (ring == 0) {
+                scan_cell(query_x, query_y);
+                continue;
+            }
+            // Only the part of the ring inside the bounding box is visited
+            long long from_x = std::max<long long>(query_x - ring, grid.min_x);
+            long long to_x = std::min<long long>(query_x + ring, grid.max_x);
+            long long from_y = std::max<long long>(query_y - ring + 1, grid.min_y);
+            long long to_y = std::min<long long>(query_y + ring - 1, grid.max_y);
+            for (long long row : {query_y - ring, query_y + ring}) {
+                if (row >= grid.min_y && row <= grid.max_y) {
+                    for (long long column = from_x; column <= to_x; ++column) {
+                        scan_cell(column, row);
+                    }
+                }
+            }
+            for (long long column : {query_x - ring, query_x + ring}) {
+                if (column >= grid.min_x && column <= grid.max_x) {
+                    for (long long row = from_y; row <= to_y; ++row) {
+                        scan_cell(column, row);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<AffiliationHandle> result;
+    result.reserve(best.size());
+    for (const auto& candidate : best) {
+        result.push_back(candidate.second);
+    }
+    return result;
+}
+
+void Datastructures::rebuild_ancestors()
+{
+    std::size_t count = publication_parent.size();
+
+    // Depths first, walking up only until a node with a known depth
+    std::vector<bool> known(count, false);
+    std::vector<PublicationHandle> chain;
+    std::uint32_t max_depth = 0;
+    for (PublicationHandle handle = 0; handle < count; ++handle) {
+        PublicationHandle current = handle;
+        while (!known[current] && publication_parent[current] != NO_HANDLE) {
+            chain.push_back(current);
+            current = publication_parent[current];
+        }
+        if (!known[current]) {
+            known[current] = true;
+            reference_depth[current] = 0;
+        }
+        while (!chain.empty()) {
+            PublicationHandle child = chain.back();
+            chain.pop_back();
+            reference_depth[child] = reference_depth[publication_parent[child]] + 1;
+            known[child] = true;
+            max_depth = std::max(max_depth, reference_depth[child]);
+        }
+    }
+
+    // Enough levels that any depth difference can be jumped
+    std::size_t levels = 1;
+    while ((std::uint64_t(1) << levels) <= max_depth) {
+        ++levels;
+    }
+    ancestors.assign(levels, std::vector<PublicationHandle>(count));
+    for (PublicationHandle handle = 0; handle < count; ++handle) {
+        ancestors[0][handle] = publication_parent[handle] != NO_HANDLE ? publication_parent[handle] : handle;
+    }
+    for (std::size_t level = 1; level < levels; ++level) {
+        for (PublicationHandle handle = 0; handle < count; ++handle) {
+            ancestors[level][handle] = ancestors[level - 1][ancestors[level - 1][handle]];
+        }
+    }
+    ancestors_dirty = false;
+}
+
+void Datastructures::attach_reference(PublicationHandle child, PublicationHandle parent, bool has_children)
+{
+    bool was_attached = publication_parent[child] != NO_HANDLE;
+    publication_parent[child] = parent;
+    if (ancestors_dirty) {
+        return;
+    }
+    if (was_attached || has_children) {
+        // Moves a whole subtree, cheaper to rebuild when next needed
+        ancestors_dirty = true;
+        return;
+    }
+
+    reference_depth[child] = reference_depth[parent] + 1;
+    if ((std::uint64_t(1) << ancestors.size()) <= reference_depth[child]) {
+        // One more level is needed to reach the new depth
+        const std::vector<PublicationHandle>& top = ancestors.back();
+        std::vector<PublicationHandle> level(top.size());
+        for (PublicationHandle handle = 0; handle < top.size(); ++handle) {
+            level[handle] = top[top[handle]];
+        }
+        ancestors.push_back(std::move(level));
+    }
+    ancestors[0][child] = parent;
+    for (std::size_t level = 1; level < ancestors.size(); ++level) {
+        ancestors[level][child] = ancestors[level - 1][ancestors[level - 1][child]];
+    }
+}
+
+PublicationHandle Datastructures::common_ancestor(PublicationHandle first, PublicationHandle second)
+{
+    if (reference_depth[first] < reference_depth[second]) {
+        std::swap(first, second);
+    }
+    std::uint32_t difference = reference_depth[first] - reference_depth[second];
+    for (std::size_t level = 0; difference != 0; ++level, difference >>= 1) {
+        if (difference & 1) {
+            first = ancestors[level][first];
+        }
+    }
+    if (first == second) {
+        return first;
+    }
+    for (std::size_t level = ancestors.size(); level-- > 0;) {
+        if (ancestors[level][first] != ancestors[level][second]) {
+            first = ancestors[level][first];
+            second = ancestors[level][second];
+        }
+    }
+    // Now both are just below the common ancestor, or roots of different trees
+    return ancestors[0][first] == ancestors[0][second] ? ancestors[0][first] : NO_HANDLE;
+}
+
+void Datastructures::rebuild_preorder()
+{
+    std::size_t count = publication_ids.size();
+    preorder.clear();
+    preorder.reserve(count);
+    preorder_entry.assign(count, 0);
+    preorder_exit.assign(count, 0);
+
+    // Iterative walk so that deep reference chains can't overflow the stack.
+    // Each frame is a publication and the index of its next child.
+    std::vector<std::pair<const Publication*, std::size_t>> stack;
+    for (PublicationHandle root = 0; root < count; ++root) {
+        if (publication_parent[root] != NO_HANDLE || publication_ids[root] == NO_PUBLICATION) {
+            continue;
+        }
+        const Publication* publication = &publication_by_ids.find(publication_ids[root])->second;
+        preorder_entry[root] = static_cast<std::uint32_t>(preorder.size());
+        preorder.push_back(root);
+        stack.emplace_back(publication, 0);
+        while (!stack.empty()) {
+            auto& [current, next_child] = stack.back();
+            if (next_child == current->children.size()) {
+                preorder_exit[current->handle] = static_cast<std::uint32_t>(preorder.size());
+                stack.pop_back();
+                continue;
+            }
+            const Publication* child = &publication_by_ids.find(current->children[next_child++])->second;
+            preorder_entry[child->handle] = static_cast<std::uint32_t>(preorder.size());
+            preorder.push_back(child->handle);
+            stack.emplace_back(child, 0);
+        }
+    }
+    preorder_dirty = false;
+}
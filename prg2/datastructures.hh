@@ -1,462 +1,965 @@
-// Datastructures.hh
-//
-// Student name:Marius Cedric Ishimwe
-// Student email:marius.ishimwe@tuni.fi
-// Student number:151104952
-
-#ifndef DATASTRUCTURES_HH
-#define DATASTRUCTURES_HH
-
-#include <string>
-#include <vector>
-#include <tuple>
-#include <utility>
-#include <limits>
-#include <functional>
-#include <exception>
-#include <queue>
-#include <unordered_set>
-
-// Types for IDs
-using AffiliationID = std::string;
-using PublicationID = unsigned long long int;
-using Name = std::string;
-using Year = unsigned short int;
-using Weight = int;
-struct Connection;
-// Type for a distance (in arbitrary units)
-using Distance = int;
-
-using Path = std::vector<Connection>;
-using PathWithDist = std::vector<std::pair<Connection,Distance>>;
-
-// Return values for cases where required thing was not found
-AffiliationID const NO_AFFILIATION = "---";
-PublicationID const NO_PUBLICATION = -1;
-Name const NO_NAME = "!NO_NAME!";
-Year const NO_YEAR = -1;
-Weight const NO_WEIGHT = -1;
-
-// Return value for cases where integer values were not found
-int const NO_VALUE = std::numeric_limits<int>::min();
-
-// Type for a coordinate (x, y)
-struct Coord
-{
-    int x = NO_VALUE;
-    int y = NO_VALUE;
-};
-
-
-// Example: Defining == and hash function for Coord so that it can be used
-// as key for std::unordered_map/set, if needed
-inline bool operator==(Coord c1, Coord c2) { return c1.x == c2.x && c1.y == c2.y; }
-inline bool operator!=(Coord c1, Coord c2) { return !(c1==c2); } // Not strictly necessary
-
-struct CoordHash
-{
-    std::size_t operator()(Coord xy) const
-    {
-        auto hasher = std::hash<int>();
-        auto xhash = hasher(xy.x);
-        auto yhash = hasher(xy.y);
-        // Combine hash values (magic!)
-        return xhash ^ (yhash + 0x9e3779b9 + (xhash << 6) + (xhash >> 2));
-    }
-};
-
-// Example: Defining < for Coord so that it can be used
-// as key for std::map/set
-inline bool operator<(Coord c1, Coord c2)
-{
-    if (c1.y < c2.y) { return true; }
-    else if (c2.y < c1.y) { return false; }
-    else { return c1.x < c2.x; }
-}
-
-// Return value for cases where coordinates were not found
-Coord const NO_COORD = {NO_VALUE, NO_VALUE};
-
-struct Connection
-{
-    AffiliationID aff1 = NO_AFFILIATION;
-    AffiliationID aff2 = NO_AFFILIATION;
-    Weight weight = NO_WEIGHT;
-    bool operator==(const Connection& c1) const{
-        return (aff1==c1.aff1) && (aff2==c1.aff2) && (weight==c1.weight);
-    }
-};
-const Connection NO_CONNECTION{NO_AFFILIATION,NO_AFFILIATION,NO_WEIGHT};
-
-
-// Return value for cases where Distance is unknown
-Distance const NO_DISTANCE = NO_VALUE;
-
-struct Affiliation {
-    AffiliationID id;
-    Name name;
-    Coord xy;
-    double distance;
-};
-
-struct Publication {
-    PublicationID id;
-    Name name;
-    Year year;
-    std::vector<AffiliationID> by_affiliations;
-    PublicationID parent = NO_PUBLICATION;
-    std::vector<PublicationID> children = std::vector<PublicationID>();
-};
-
-// This exception class is there just so that the user interface can notify
-// about operations which are not (yet) implemented
-class NotImplemented : public std::exception
-{
-public:
-    NotImplemented() : msg_{} {}
-    explicit NotImplemented(std::string const& msg) : msg_{msg + " not implemented"} {}
-
-    virtual const char* what() const noexcept override
-    {
-        return msg_.c_str();
-    }
-private:
-    std::string msg_;
-};
-
-// This is the class you are supposed to implement
-
-class Datastructures
-{
-public:
-    Datastructures();
-    ~Datastructures();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    unsigned int get_affiliation_count();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    void clear_all();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<AffiliationID> get_all_affiliations();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool add_affiliation(AffiliationID id, Name const& name, Coord xy);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Name get_affiliation_name(AffiliationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Coord get_affiliation_coord(AffiliationID id);
-
-
-    // We recommend you implement the operations below only after implementing the ones above
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<AffiliationID> get_affiliations_alphabetically();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<AffiliationID> get_affiliations_distance_increasing();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    AffiliationID find_affiliation_with_coord(Coord xy);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool change_affiliation_coord(AffiliationID id, Coord newcoord);
-
-
-    // We recommend you implement the operations below only after implementing the ones above
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool add_publication(PublicationID id, Name const& name, Year year, const std::vector<AffiliationID> & affiliations);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<PublicationID> all_publications();
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Name get_publication_name(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Year get_publication_year(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<AffiliationID> get_affiliations(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool add_reference(PublicationID id, PublicationID parentid);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<PublicationID> get_direct_references(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<PublicationID> get_publications(AffiliationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    PublicationID get_parent(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<std::pair<Year, PublicationID>> get_publications_after(AffiliationID affiliationid, Year year);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<PublicationID> get_referenced_by_chain(PublicationID id);
-
-
-    // Non-compulsory operations
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<PublicationID> get_all_references(PublicationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    std::vector<AffiliationID> get_affiliations_closest_to(Coord xy);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool remove_affiliation(AffiliationID id);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    PublicationID get_closest_common_parent(PublicationID id1, PublicationID id2);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    bool remove_publication(PublicationID publicationid);
-
-    // PRG 2 functions:
-
-    // Estimate of performance:O(n)
-    // Short rationale for estimate: Hashmap being used for storing affiliationid to publications vector
-    std::vector<Connection> get_connected_affiliations(AffiliationID id);
-
-    // Estimate of performance:O(n)
-    // Short rationale for estimate: Also hashmap being used for storing affiliation id to publications vector
-    std::vector<Connection> get_all_connections();
-
-    // Estimate of performance:O(n^2)
-    // Short rationale for estimate: Also hashmap being used for storing affiliation id to publications vector
-    Path get_any_path(AffiliationID source, AffiliationID target);
-
-    // PRG2 optional functions
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Path get_path_with_least_affiliations(AffiliationID source, AffiliationID target);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    Path get_path_of_least_friction(AffiliationID source, AffiliationID target);
-
-    // Estimate of performance:
-    // Short rationale for estimate:
-    PathWithDist get_shortest_path(AffiliationID source, AffiliationID target);
-
-
-private:
-
-    std::unordered_map<AffiliationID, Affiliation> affiliation_by_ids;
-
-
-    std::vector<AffiliationID> all_affiliation_ids;
-    std::vector<Affiliation> all_affiliations;
-
-    std::vector<Publication> all_Publications;
-    std::unordered_map<PublicationID, Publication> publication_by_ids;
-    std::unordered_map<AffiliationID, std::vector<PublicationID>> affiliation_publications;
-
-    std::vector<Connection*> all_connections;
-    std::unordered_map<AffiliationID, std::vector<Connection*>> connection_by_id;
-
-    void pre_traverse(PublicationID id, std::vector<PublicationID>&result){
-        if (publication_by_ids.find(id) != publication_by_ids.end()) {
-                result.push_back(id);
-                for (PublicationID child : publication_by_ids[id].children) {
-                    pre_traverse(child, result);
-                }
-            }
-    }
-    void create_connection(Publication pub, AffiliationID aff_to_fix = NO_AFFILIATION){
-        if (aff_to_fix == NO_AFFILIATION) {
-                for (size_t i = 0; i < pub.by_affiliations.size(); ++i) {
-
-                    for (size_t j = i + 1; j < pub.by_affiliations.size(); ++j) {
-                        AffiliationID target;
-                        AffiliationID source;
-                        if (pub.by_affiliations[i] < pub.by_affiliations[j]) {
-                            source = pub.by_affiliations[i];
-                            target = pub.by_affiliations[j];
-                        }
-                        else {
-                            source = pub.by_affiliations[j];
-                            target = pub.by_affiliations[i];
-                        }
-                        if (target == source) {
-                            break;
-                        }
-                        bool exist = false;
-                        auto it = connection_by_id.find(source);
-
-                        if (it != connection_by_id.end()) {
-                            std::vector<Connection*>& connections = it->second;
-                            for (Connection* conn : connections) {
-                                if (conn->aff1 == source && conn->aff2 == target) {
-
-                                    exist = true;
-                                    conn->weight += 1;
-                                    break;
-                                }
-                            }
-
-                            if (!exist) {
-                                Connection* connection = new Connection{source, target, 1};
-                                Connection* connection_reverse = new Connection{target, source, 1};
-                                all_connections.push_back(connection);
-
-                                connection_by_id[source].push_back(connection);
-                                connection_by_id[target].push_back(connection_reverse);
-
-                            }
-
-                        }
-                        if (exist) {
-                            auto it_reverse = connection_by_id.find(target);
-                            if (it_reverse != connection_by_id.end()) {
-                                std::vector<Connection*>& connections_reverse = it_reverse->second;
-                                for (Connection* conn : connections_reverse) {
-                                    if (conn->aff1 == target && conn->aff2 == source) {
-                                        conn->weight += 1;
-                                        break;
-                                    }
-                                }
-                            }
-
-                        }
-                    }
-                }
-            } else {
-                for (size_t i = 0; i < pub.by_affiliations.size(); ++i) {
-                    AffiliationID target;
-                    AffiliationID source;
-                    if (pub.by_affiliations[i] < aff_to_fix) {
-                        source = pub.by_affiliations[i];
-                        target = aff_to_fix;
-                    }
-                    else {
-                        source = aff_to_fix;
-                        target = pub.by_affiliations[i];
-                    }
-                    if (target == source) {
-                        break;
-                    }
-                    bool exist = false;
-                    auto it = connection_by_id.find(source);
-
-                    if (it != connection_by_id.end()) {
-                        std::vector<Connection*>& connections = it->second;
-                        for (Connection* conn : connections) {
-                            if (conn->aff1 == source && conn->aff2 == target) {
-
-                                exist = true;
-                                conn->weight += 1;
-                                break;
-                            }
-                        }
-
-                        if (!exist) {
-                            Connection* connection = new Connection{source, target, 1};
-                            Connection* connection_reverse = new Connection{target, source, 1};
-                            all_connections.push_back(connection);
-
-                            connection_by_id[source].push_back(connection);
-                            connection_by_id[target].push_back(connection_reverse);
-
-                        }
-
-                    }
-                    if (exist) {
-                        auto it_reverse = connection_by_id.find(target);
-                        if (it_reverse != connection_by_id.end()) {
-                            std::vector<Connection*>& connections_reverse = it_reverse->second;
-                            for (Connection* conn : connections_reverse) {
-                                if (conn->aff1 == target && conn->aff2 == source) {
-                                    conn->weight += 1;
-                                    break;
-                                }
-                            }
-                        }
-
-                    }
-                }
-            }
-    }
-    std::vector<PublicationID> get_common_publication(AffiliationID id1, AffiliationID id2){
-        std::vector<PublicationID> pub1 = get_publications(id1);
-            std::vector<PublicationID> pub2 = get_publications(id2);
-
-            std::vector<PublicationID> commonPublications;
-            if (id1 == id2) {
-                return commonPublications;
-            }
-            for (const PublicationID id : pub1) {
-                if (std::find(pub2.begin(), pub2.end(), id) != pub2.end()) {
-                    commonPublications.push_back(id);
-                }
-            }
-
-            return commonPublications;
-    }
-    bool find_path(AffiliationID current, AffiliationID target, std::vector<Connection>& path, std::unordered_map<AffiliationID, bool>& visited){
-        if (current == target) {
-                return true;
-            }
-
-            visited[current] = true;
-
-            for (const Connection* connection : connection_by_id[current]) {
-
-
-                if (!visited[connection->aff2]) {
-                    path.push_back(*connection);
-
-                    if (find_path(connection->aff2, target, path, visited)) {
-
-                        return true;
-                    }
-                    path.pop_back();
-                }
-            }
-
-            return false;
-    }
-
-
-
-};
-
-#endif // DATASTRUCTURES_HH
+// Datastructures.hh
+//
+// Student name:Marius Cedric Ishimwe
+// Student email:marius.ishimwe@tuni.fi
+// Student number:151104952
+
+#ifndef DATASTRUCTURES_HH
+#define DATASTRUCTURES_HH
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <limits>
+#include <functional>
+#include <exception>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <iterator>
+#include <string_view>
+
+// Types for IDs
+using AffiliationID = std::string;
+using PublicationID = unsigned long long int;
+using Name = std::string;
+using Year = unsigned short int;
+using Weight = int;
+// Dense handle given to each AffiliationID when it is first seen. Internal
+// tables are indexed by it, strings are only used at the API boundary.
+using AffiliationHandle = std::uint32_t;
+// Dense handle given to each publication when it is added, indexes the
+// reference forest tables
+using PublicationHandle = std::uint32_t;
+struct Connection;
+// Type for a distance (in arbitrary units)
+using Distance = int;
+
+using Path = std::vector<Connection>;
+using PathWithDist = std::vector<std::pair<Connection,Distance>>;
+
+// Return values for cases where required thing was not found
+AffiliationID const NO_AFFILIATION = "---";
+PublicationID const NO_PUBLICATION = -1;
+Name const NO_NAME = "!NO_NAME!";
+Year const NO_YEAR = -1;
+Weight const NO_WEIGHT = -1;
+
+// Return value for cases where integer values were not found
+int const NO_VALUE = std::numeric_limits<int>::min();
+
+// Type for a coordinate (x, y)
+struct Coord
+{
+    int x = NO_VALUE;
+    int y = NO_VALUE;
+};
+
+
+// Example: Defining == and hash function for Coord so that it can be used
+// as key for std::unordered_map/set, if needed
+inline bool operator==(Coord c1, Coord c2) { return c1.x == c2.x && c1.y == c2.y; }
+inline bool operator!=(Coord c1, Coord c2) { return !(c1==c2); } // Not strictly necessary
+
+struct CoordHash
+{
+    std::size_t operator()(Coord xy) const
+    {
+        auto hasher = std::hash<int>();
+        auto xhash = hasher(xy.x);
+        auto yhash = hasher(xy.y);
+        // Combine hash values (magic!)
+        return xhash ^ (yhash + 0x9e3779b9 + (xhash << 6) + (xhash >> 2));
+    }
+};
+
+// Example: Defining < for Coord so that it can be used
+// as key for std::map/set
+inline bool operator<(Coord c1, Coord c2)
+{
+    if (c1.y < c2.y) { return true; }
+    else if (c2.y < c1.y) { return false; }
+    else { return c1.x < c2.x; }
+}
+
+// Return value for cases where coordinates were not found
+Coord const NO_COORD = {NO_VALUE, NO_VALUE};
+
+struct Connection
+{
+    AffiliationID aff1 = NO_AFFILIATION;
+    AffiliationID aff2 = NO_AFFILIATION;
+    Weight weight = NO_WEIGHT;
+    bool operator==(const Connection& c1) const{
+        return (aff1==c1.aff1) && (aff2==c1.aff2) && (weight==c1.weight);
+    }
+};
+const Connection NO_CONNECTION{NO_AFFILIATION,NO_AFFILIATION,NO_WEIGHT};
+
+
+// Return value for cases where Distance is unknown
+Distance const NO_DISTANCE = NO_VALUE;
+
+// Handle value for ids that have not been interned (affiliations and publications)
+AffiliationHandle const NO_HANDLE = std::numeric_limits<AffiliationHandle>::max();
+
+struct Publication {
+    PublicationID id;
+    Name name;
+    Year year;
+    std::vector<AffiliationHandle> by_affiliations;
+    PublicationID parent = NO_PUBLICATION;
+    std::vector<PublicationID> children = std::vector<PublicationID>();
+    PublicationHandle handle = NO_HANDLE;
+};
+
+// Input records for the bulk add operations, one per add_affiliation or
+// add_publication call they replace
+struct AffiliationRecord {
+    AffiliationID id;
+    Name name;
+    Coord xy;
+};
+
+struct PublicationRecord {
+    PublicationID id;
+    Name name;
+    Year year;
+    std::vector<AffiliationID> affiliations;
+};
+
+// One row of memory_usage: the estimated heap footprint of a member
+// container, or of a group of members that serve one index
+struct MemoryUsage {
+    std::string container;
+    std::size_t elements = 0;
+    std::size_t bytes = 0; // including the container objects themselves
+    std::size_t allocations = 0;
+};
+
+// This exception class is there just so that the user interface can notify
+// about operations which are not (yet) implemented
+class NotImplemented : public std::exception
+{
+public:
+    NotImplemented() : msg_{} {}
+    explicit NotImplemented(std::string const& msg) : msg_{msg + " not implemented"} {}
+
+    virtual const char* what() const noexcept override
+    {
+        return msg_.c_str();
+    }
+private:
+    std::string msg_;
+};
+
+// This is the class you are supposed to implement
+
+class Datastructures
+{
+public:
+    Datastructures();
+    ~Datastructures();
+    // The ordered indexes refer back to the affiliation table of their own object
+    Datastructures(const Datastructures&) = delete;
+    Datastructures& operator=(const Datastructures&) = delete;
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: Size of the vector of existing affiliations
+    unsigned int get_affiliation_count();
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    void clear_all();
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    std::vector<AffiliationID> get_all_affiliations();
+
+    // Estimate of performance: O(log n)
+    // Short rationale for estimate: Hashmap inserts plus inserts into the two ordered sets
+    bool add_affiliation(AffiliationID id, Name const& name, Coord xy);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    Name get_affiliation_name(AffiliationID id);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    Coord get_affiliation_coord(AffiliationID id);
+
+
+    // We recommend you implement the operations below only after implementing the ones above
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Copies ids out of a name ordered set kept up to date on add/change/remove
+    std::vector<AffiliationID> get_affiliations_alphabetically();
+
+    // Estimate of performance: O(n)
+    // Short rationale for estimate: Copies ids out of a distance ordered set kept up to date on add/change/remove
+    std::vector<AffiliationID> get_affiliations_distance_increasing();
+
+    // Estimate of performance: O(1) average
+    // Short rationale for estimate: Hashmap lookup from coordinate to id
+    AffiliationID find_affiliation_with_coord(Coord xy);
+
+    // Estimate of performance: O(log n)
+    // Short rationale for estimate: Hashmap lookups plus one erase and insert in the distance set
+    bool change_affiliation_coord(AffiliationID id, Coord newcoord);
+
+
+    // We recommend you implement the operations below only after implementing the ones above
+
+    // Estimate of performance: O(k^2) average, k = number of affiliations, O(k^2 d) once the spanning forest is built
+    // Short rationale for estimate: Each affiliation pair finds its link through a hashmap, then walks the forest path between them, d = depth of the forest
+    bool add_publication(PublicationID id, Name const& name, Year year, const std::vector<AffiliationID> & affiliations);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    std::vector<PublicationID> all_publications();
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    Name get_publication_name(PublicationID id);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    Year get_publication_year(PublicationID id);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    std::vector<AffiliationID> get_affiliations(PublicationID id);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    bool add_reference(PublicationID id, PublicationID parentid);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    std::vector<PublicationID> get_direct_references(PublicationID id);
+
+    // Estimate of performance: O(k) average, k = affiliations of the publication, O(k d) once the spanning forest is built
+    // Short rationale for estimate: One hashmap link lookup per existing co-author, then a walk of the forest path between them, d = depth of the forest
+    bool add_affiliation_to_publication(AffiliationID affiliationid, PublicationID publicationid);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    std::vector<PublicationID> get_publications(AffiliationID id);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    PublicationID get_parent(PublicationID id);
+
+    // Estimate of performance: O(log p + k)
+    // Short rationale for estimate: Binary search in the affiliation's year ordered publications, then a copy
+    std::vector<std::pair<Year, PublicationID>> get_publications_after(AffiliationID affiliationid, Year year);
+
+    // Estimate of performance: O(d), d = length of the chain
+    // Short rationale for estimate: Follows the compact parent table, no publication is copied
+    std::vector<PublicationID> get_referenced_by_chain(PublicationID id);
+
+
+    // Non-compulsory operations
+
+    // Estimate of performance: O(k), O(n) after the forest has been reshaped
+    // Short rationale for estimate: Copies a contiguous slice of the preorder index, rebuilt lazily
+    std::vector<PublicationID> get_all_references(PublicationID id);
+
+    // Estimate of performance: O(1) average for evenly spread coordinates, O(n) worst case
+    // Short rationale for estimate: Searches rings of grid cells around xy until no closer cell can remain
+    std::vector<AffiliationID> get_affiliations_closest_to(Coord xy);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    bool remove_affiliation(AffiliationID id);
+
+    // Estimate of performance: O(log n), O(n log n) after the forest has been reshaped
+    // Short rationale for estimate: Binary lifting over the parent table, rebuilt lazily
+    PublicationID get_closest_common_parent(PublicationID id1, PublicationID id2);
+
+    // Estimate of performance:
+    // Short rationale for estimate:
+    bool remove_publication(PublicationID publicationid);
+
+    // PRG 2 functions:
+
+    // Estimate of performance:O(n)
+    // Short rationale for estimate: Hashmap being used for storing affiliationid to publications vector
+    std::vector<Connection> get_connected_affiliations(AffiliationID id);
+
+    // Estimate of performance:O(n)
+    // Short rationale for estimate: Also hashmap being used for storing affiliation id to publications vector
+    std::vector<Connection> get_all_connections();
+
+    // Estimate of performance:O(n + e)
+    // Short rationale for estimate: Iterative DFS, only touches the part of the graph it explores
+    Path get_any_path(AffiliationID source, AffiliationID target);
+
+    // PRG2 optional functions
+
+    // Estimate of performance: O(n + e), usually far less
+    // Short rationale for estimate: Bidirectional BFS, stops when the two frontiers meet
+    Path get_path_with_least_affiliations(AffiliationID source, AffiliationID target);
+
+    // Estimate of performance: O(n + e)
+    // Short rationale for estimate: The forest path gives the bottleneck in O(d), d = depth of the forest, then a bidirectional BFS runs over the connections at least that heavy
+    Path get_path_of_least_friction(AffiliationID source, AffiliationID target);
+
+    // Estimate of performance: O((n + e) log n), usually far less
+    // Short rationale for estimate: A* with straight line distance to target as heuristic, binary heap
+    PathWithDist get_shortest_path(AffiliationID source, AffiliationID target);
+
+    // Number of affiliations whose connections were scanned by the latest
+    // path query, for measuring search efficiency
+    unsigned int get_last_search_expansions();
+
+    // Selects between A* (default) and plain Dijkstra in get_shortest_path.
+    // Both find the shortest length; equally short paths may differ.
+    void set_shortest_path_heuristic(bool enabled);
+
+    // Estimate of performance: O(1), O(n) after the forest has been reshaped
+    // Short rationale for estimate: Size of the publication's preorder interval
+    // Number of publications get_all_references(id) would return, 0 for unknown ids
+    unsigned int get_reference_count(PublicationID id);
+
+    // Estimate of performance: O(1), O(n) after the forest has been reshaped
+    // Short rationale for estimate: Interval containment in the preorder index
+    // True if id is among get_all_references(ancestorid)
+    bool is_referenced_by(PublicationID id, PublicationID ancestorid);
+
+    // Estimate of performance: O(k log k + k log n) worst case, O(k log k + n) when the new names and distances
+    // don't interleave with the existing ones, k = number of records
+    // Short rationale for estimate: Capacity is reserved once, sorted new entries are inserted next to each other
+    // Same result as calling add_affiliation for each record in order,
+    // returns the number of affiliations added
+    unsigned int add_affiliations_bulk(std::vector<AffiliationRecord> const& records);
+
+    // Estimate of performance: O(sum of a^2 + k log k), a = affiliations per record, O(d) more per pair when the batch is small next to the built spanning forest
+    // Short rationale for estimate: Hashmap link lookups per affiliation pair, year lists sorted once per touched affiliation; a larger batch marks the forest for rebuilding instead of walking it, d = depth of the forest
+    // Same result as calling add_publication for each record in order,
+    // returns the number of publications added
+    unsigned int add_publications_bulk(std::vector<PublicationRecord> const& records);
+
+    // Estimate of performance: O(n + p + e)
+    // Short rationale for estimate: Tables are written out as they are, strings one by one
+    // Writes everything to a versioned binary file, returns false if writing fails
+    bool save_snapshot(std::string const& filename);
+
+    // Estimate of performance: O(n log n + p log p + e)
+    // Short rationale for estimate: Arrays are copied in as they are, only the ordered indexes are re-sorted
+    // Replaces the contents with a file written by save_snapshot. Returns false
+    // and leaves the contents unchanged if the file is missing or malformed.
+    bool load_snapshot(std::string const& filename);
+
+    // Estimate of performance: O(n log n + p log p + e)
+    // Short rationale for estimate: The file is mapped, not copied, but every section is validated once
+    // Replaces the contents with a read-only mapping of a snapshot file, so
+    // that processes opening the same file share one copy in the page cache.
+    // Lookups by id, publication and connection queries and the path queries
+    // are answered from the mapping. Any other operation first copies the
+    // snapshot into memory as load_snapshot does and releases the mapping.
+    // The file must not be rewritten while it is mapped.
+    bool map_snapshot(std::string const& filename);
+
+    // Estimate of performance: O(n + p + e)
+    // Short rationale for estimate: Every element is visited once to add up the strings and vectors it owns
+    // Estimated heap use of each member, computed from sizes and capacities
+    // as libstdc++ and glibc malloc would lay them out. A mapped snapshot
+    // is reported as the size of the file.
+    std::vector<MemoryUsage> memory_usage();
+
+    // Estimate of performance: O(n + k log k)
+    // Short rationale for estimate: One vectorized pass over the coordinate columns, then a partial selection
+    // The k existing affiliations closest to xy, ordered by distance, then
+    // y coordinate, then id
+    std::vector<AffiliationID> get_affiliations_closest_to_k(Coord xy, unsigned int k);
+
+    // Estimate of performance: O(n + m log m), m = affiliations within the radius
+    // Short rationale for estimate: One vectorized pass over the coordinate columns, then the matches are sorted
+    // Existing affiliations at most radius away from xy, in the same order
+    // as get_affiliations_closest_to_k
+    std::vector<AffiliationID> get_affiliations_within_radius(Coord xy, int radius);
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: A CPU feature check
+    // Selects the distance kernel of the two queries above: "avx2", "sse2",
+    // "scalar", or "auto" for the widest one the CPU supports. Returns the
+    // kernel in use, or an empty string if the requested one isn't available.
+    std::string set_distance_kernel(std::string const& name);
+
+    // Estimate of performance: O(c + k log k), c = grid cells the rectangle overlaps, at most the occupied ones
+    // Short rationale for estimate: Only the grid cells overlapping the rectangle are scanned, then the k found are sorted
+    // Existing affiliations with min.x <= x <= max.x and min.y <= y <= max.y,
+    // ordered by y coordinate, then x coordinate, then id
+    std::vector<AffiliationID> get_affiliations_in_rect(Coord min, Coord max);
+
+    // Estimate of performance: O(1)
+    // Short rationale for estimate: The box is extended whenever a coordinate is set
+    // {min, max} of a rectangle containing every existing affiliation, or
+    // {NO_COORD, NO_COORD} if there are none. It doesn't shrink when
+    // affiliations move or are removed, only on clear_all.
+    std::pair<Coord, Coord> get_affiliation_extent();
+
+
+private:
+
+    // Connection between two interned affiliations, aff1 has the smaller id.
+    // One record serves both directions so the weight is stored only once.
+    struct Link {
+        AffiliationHandle aff1;
+        AffiliationHandle aff2;
+        Weight weight;
+    };
+    using LinkIndex = std::uint32_t;
+
+    // Read-only view of a contiguous array, the contents of a vector or a
+    // section of a mapped snapshot
+    template <typename Type>
+    struct ArrayView {
+        const Type* data = nullptr;
+        std::size_t count = 0;
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const Type& operator[](std::size_t index) const { return data[index]; }
+        const Type& back() const { return data[count - 1]; }
+        const Type* begin() const { return data; }
+        const Type* end() const { return data + count; }
+    };
+    template <typename Type>
+    static ArrayView<Type> view_of(const std::vector<Type>& values) {
+        return {values.data(), values.size()};
+    }
+
+    // Bounding box that only grows, empty until the first coordinate
+    struct CoordBox {
+        Coord min = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+        Coord max = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+        void extend(Coord xy) {
+            min = {std::min(min.x, xy.x), std::min(min.y, xy.y)};
+            max = {std::max(max.x, xy.x), std::max(max.y, xy.y)};
+        }
+        bool empty() const { return min.x > max.x; }
+    };
+
+    // Sections of a snapshot file mapped into memory. Variable length data is
+    // stored as an offsets array with one more entry than there are items,
+    // item i being values[offsets[i], offsets[i+1]). Every section is checked
+    // when the file is opened, so the accessors trust the contents.
+    struct MappedSnapshot {
+        const char* base = nullptr;
+        std::size_t length = 0;
+        std::vector<char> buffer; // holds the file where it can't be mapped
+
+        // Indexed by AffiliationHandle
+        ArrayView<std::uint8_t> affiliation_flags; // 1 = exists, 2 = its id resolves to this slot
+        ArrayView<Coord> affiliation_coords;
+        ArrayView<std::uint64_t> affiliation_id_offsets;
+        ArrayView<char> affiliation_id_chars;
+        ArrayView<std::uint64_t> affiliation_name_offsets;
+        ArrayView<char> affiliation_name_chars;
+        ArrayView<std::uint64_t> affiliation_publication_offsets;
+        ArrayView<PublicationID> affiliation_publications;
+        ArrayView<AffiliationHandle> affiliations_by_id; // resolving slots in id order
+        ArrayView<AffiliationHandle> affiliation_order; // get_all_affiliations
+        ArrayView<AffiliationHandle> coord_owners;
+        CoordBox extent; // of the existing affiliations, found while validating
+
+        // Indexed by PublicationHandle
+        ArrayView<PublicationID> publication_ids;
+        ArrayView<PublicationHandle> publication_parents;
+        ArrayView<Year> publication_years;
+        ArrayView<std::uint64_t> publication_name_offsets;
+        ArrayView<char> publication_name_chars;
+        ArrayView<std::uint64_t> publication_affiliation_offsets;
+        ArrayView<AffiliationHandle> publication_affiliations;
+        ArrayView<std::uint64_t> publication_child_offsets;
+        ArrayView<PublicationID> publication_children;
+        ArrayView<PublicationHandle> publications_by_id; // live publications in id order
+
+        ArrayView<Link> links;
+        ArrayView<std::uint32_t> graph_offsets;
+        ArrayView<AffiliationHandle> graph_neighbours;
+        ArrayView<Weight> graph_weights;
+        ArrayView<AffiliationHandle> forest_parents;
+        ArrayView<Weight> forest_weights;
+
+        bool active() const { return base != nullptr; }
+        template <typename Type>
+        static ArrayView<Type> slice(ArrayView<std::uint64_t> offsets, ArrayView<Type> values, std::size_t index) {
+            return {values.data + offsets[index], offsets[index + 1] - offsets[index]};
+        }
+        static std::string_view text(ArrayView<std::uint64_t> offsets, ArrayView<char> chars, std::size_t index) {
+            return {chars.data + offsets[index], offsets[index + 1] - offsets[index]};
+        }
+        std::string_view affiliation_id(AffiliationHandle handle) const {
+            return text(affiliation_id_offsets, affiliation_id_chars, handle);
+        }
+        std::string_view affiliation_name(AffiliationHandle handle) const {
+            return text(affiliation_name_offsets, affiliation_name_chars, handle);
+        }
+        std::string_view publication_name(PublicationHandle handle) const {
+            return text(publication_name_offsets, publication_name_chars, handle);
+        }
+        AffiliationHandle find_affiliation(std::string_view id) const {
+            auto it = std::lower_bound(affiliations_by_id.begin(), affiliations_by_id.end(), id,
+                                       [this](AffiliationHandle handle, std::string_view key) { return affiliation_id(handle) < key; });
+            return (it != affiliations_by_id.end() && affiliation_id(*it) == id) ? *it : NO_HANDLE;
+        }
+        PublicationHandle find_publication(PublicationID id) const {
+            auto it = std::lower_bound(publications_by_id.begin(), publications_by_id.end(), id,
+                                       [this](PublicationHandle handle, PublicationID key) { return publication_ids[handle] < key; });
+            return (it != publications_by_id.end() && publication_ids[*it] == id) ? *it : NO_HANDLE;
+        }
+    };
+    MappedSnapshot mapped;
+    // Maps and validates a snapshot file into snapshot, which is left empty on failure
+    static bool open_snapshot(const std::string& filename, MappedSnapshot& snapshot);
+    static void release_snapshot(MappedSnapshot& snapshot);
+    // Copies the mapped snapshot into the structures below and releases it
+    void materialize_snapshot();
+    // Called first by every operation the mapping can't serve
+    void ensure_heap() {
+        if (mapped.active()) {
+            materialize_snapshot();
+        }
+    }
+
+    // Affiliation slots stored column by column and indexed by
+    // AffiliationHandle, so that scans over coordinates or distances read
+    // only those arrays. Ids and names are kept in character arenas: ids in
+    // handle order, names in the order the affiliations were added.
+    struct AffiliationTable {
+        std::vector<int> xs;
+        std::vector<int> ys;
+        std::vector<long long> distances; // squared distance from (0,0), exact for ordering
+        std::vector<std::uint8_t> exists; // 0 for ids only referenced by publications, or removed
+        std::vector<std::uint64_t> id_offsets = {0}; // id of h is id_chars[id_offsets[h], id_offsets[h+1])
+        std::vector<char> id_chars;
+        std::vector<std::uint64_t> name_offsets;
+        std::vector<std::uint32_t> name_lengths;
+        std::vector<char> name_chars;
+        CoordBox extent; // of every coordinate set since the table was cleared
+
+        std::size_t size() const { return xs.size(); }
+        Coord xy(AffiliationHandle handle) const { return {xs[handle], ys[handle]}; }
+        std::string_view id(AffiliationHandle handle) const {
+            return {id_chars.data() + id_offsets[handle], id_offsets[handle + 1] - id_offsets[handle]};
+        }
+        std::string_view name(AffiliationHandle handle) const {
+            return {name_chars.data() + name_offsets[handle], name_lengths[handle]};
+        }
+        AffiliationHandle append(std::string_view id) {
+            xs.push_back(NO_COORD.x);
+            ys.push_back(NO_COORD.y);
+            distances.push_back(0);
+            exists.push_back(0);
+            id_chars.insert(id_chars.end(), id.begin(), id.end());
+            id_offsets.push_back(id_chars.size());
+            name_offsets.push_back(0);
+            name_lengths.push_back(0);
+            return static_cast<AffiliationHandle>(xs.size() - 1);
+        }
+        // Called once per slot, when the affiliation is added
+        void set_name(AffiliationHandle handle, std::string_view name) {
+            name_offsets[handle] = name_chars.size();
+            name_lengths[handle] = static_cast<std::uint32_t>(name.size());
+            name_chars.insert(name_chars.end(), name.begin(), name.end());
+        }
+        void set_xy(AffiliationHandle handle, Coord xy) {
+            xs[handle] = xy.x;
+            ys[handle] = xy.y;
+            distances[handle] = square_distance(xy);
+            extent.extend(xy);
+        }
+        void reserve(std::size_t count) {
+            xs.reserve(count);
+            ys.reserve(count);
+            distances.reserve(count);
+            exists.reserve(count);
+            id_offsets.reserve(count + 1);
+            name_offsets.reserve(count);
+            name_lengths.reserve(count);
+        }
+        void clear() {
+            *this = AffiliationTable();
+        }
+    };
+    AffiliationTable affiliations;
+    std::unordered_map<AffiliationID, AffiliationHandle> affiliation_handles;
+
+    // Existing affiliations in the order they were added
+    std::vector<AffiliationHandle> affiliation_order;
+
+    // Order indexes maintained by add_affiliation, change_affiliation_coord
+    // and remove_affiliation so that ordered queries don't need to sort.
+    // The name index holds only handles and reads the names from the table.
+    struct NameOrder {
+        const AffiliationTable* table;
+        bool operator()(AffiliationHandle first, AffiliationHandle second) const {
+            int order = table->name(first).compare(table->name(second));
+            return order != 0 ? order < 0 : first < second;
+        }
+    };
+    std::set<AffiliationHandle, NameOrder> affiliations_by_name{NameOrder{&affiliations}};
+    std::set<std::tuple<long long, int, AffiliationHandle>> affiliations_by_distance;
+    // Several affiliations may share a coordinate
+    std::unordered_multimap<Coord, AffiliationHandle, CoordHash> affiliation_by_coord;
+    void erase_coord_owner(AffiliationHandle handle);
+
+    std::vector<Publication> all_Publications;
+    std::unordered_map<PublicationID, Publication> publication_by_ids;
+    std::vector<std::vector<PublicationID>> affiliation_publications;
+    // The same publications per affiliation ordered by (year, id), so that
+    // get_publications_after is a binary search and a copy
+    std::vector<std::vector<std::pair<Year, PublicationID>>> affiliation_publications_by_year;
+    void index_publication_year(AffiliationHandle handle, Year year, PublicationID id) {
+        auto& publications = affiliation_publications_by_year[handle];
+        std::pair<Year, PublicationID> entry{year, id};
+        publications.insert(std::upper_bound(publications.begin(), publications.end(), entry), entry);
+    }
+    void unindex_publication_year(AffiliationHandle handle, Year year, PublicationID id) {
+        auto& publications = affiliation_publications_by_year[handle];
+        auto it = std::lower_bound(publications.begin(), publications.end(), std::make_pair(year, id));
+        if (it != publications.end() && it->second == id) {
+            publications.erase(it);
+        }
+    }
+
+    // Reference forest in compact form, indexed by PublicationHandle. Slots of
+    // removed publications stay behind as unused roots.
+    std::vector<PublicationID> publication_ids;
+    std::vector<PublicationHandle> publication_parent;
+
+    // Ancestors of a publication, nearest first, streamed straight from the
+    // parent table so that walking a chain copies and allocates nothing
+    class ReferenceChain {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = PublicationHandle;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const PublicationHandle*;
+            using reference = PublicationHandle;
+
+            iterator(const PublicationHandle* parents, PublicationHandle current)
+                : parents_(parents), current_(current) {}
+            PublicationHandle operator*() const { return current_; }
+            iterator& operator++() { current_ = parents_[current_]; return *this; }
+            iterator operator++(int) { iterator old = *this; ++*this; return old; }
+            bool operator==(const iterator& other) const { return current_ == other.current_; }
+            bool operator!=(const iterator& other) const { return current_ != other.current_; }
+        private:
+            const PublicationHandle* parents_;
+            PublicationHandle current_;
+        };
+
+        ReferenceChain(const PublicationHandle* parents, PublicationHandle handle)
+            : parents_(parents), handle_(handle) {}
+        iterator begin() const { return {parents_, parents_[handle_]}; }
+        iterator end() const { return {parents_, NO_HANDLE}; }
+    private:
+        const PublicationHandle* parents_;
+        PublicationHandle handle_;
+    };
+    ReferenceChain reference_chain(PublicationHandle handle) const {
+        return ReferenceChain(mapped.active() ? mapped.publication_parents.begin() : publication_parent.data(), handle);
+    }
+
+    // Binary lifting table over the reference forest: ancestors[j][h] is the
+    // 2^j:th ancestor of h, or the root of its tree if the tree isn't that
+    // deep. Leaves attached by add_reference are added in place; anything
+    // that reshapes an existing subtree marks the table dirty instead.
+    std::vector<std::vector<PublicationHandle>> ancestors;
+    std::vector<std::uint32_t> reference_depth;
+    bool ancestors_dirty = false;
+    PublicationHandle new_publication_handle(PublicationID id) {
+        PublicationHandle handle = static_cast<PublicationHandle>(publication_ids.size());
+        publication_ids.push_back(id);
+        publication_parent.push_back(NO_HANDLE);
+        reference_depth.push_back(0);
+        preorder_entry.push_back(static_cast<std::uint32_t>(preorder.size()));
+        preorder.push_back(handle);
+        preorder_exit.push_back(static_cast<std::uint32_t>(preorder.size()));
+        if (ancestors.empty()) {
+            ancestors.emplace_back();
+        }
+        for (auto& level : ancestors) {
+            level.push_back(handle);
+        }
+        return handle;
+    }
+    void rebuild_ancestors();
+
+    // Preorder of the reference forest with children in insertion order, so
+    // the publications referenced by h directly or indirectly are exactly
+    // preorder[preorder_entry[h] + 1, preorder_exit[h]). New publications
+    // are appended as roots; anything that reshapes the forest marks it dirty.
+    std::vector<PublicationHandle> preorder;
+    std::vector<std::uint32_t> preorder_entry;
+    std::vector<std::uint32_t> preorder_exit;
+    bool preorder_dirty = false;
+    void rebuild_preorder();
+    void attach_reference(PublicationHandle child, PublicationHandle parent, bool has_children);
+    // Lowest common ancestor of the handles, NO_HANDLE if in different trees
+    PublicationHandle common_ancestor(PublicationHandle first, PublicationHandle second);
+
+    // All links in creation order. Indices are stable (links are never
+    // removed one by one), and the adjacency lists refer to them by index.
+    std::vector<Link> links;
+    std::vector<std::vector<LinkIndex>> connection_by_handle;
+
+    // Link of each connected pair, keyed by link_key, so that a repeated
+    // co-authorship finds its link without scanning a hub's adjacency list
+    std::unordered_map<std::uint64_t, LinkIndex> link_by_pair;
+    static std::uint64_t link_key(AffiliationHandle first, AffiliationHandle second) {
+        if (second < first) {
+            std::swap(first, second);
+        }
+        return (static_cast<std::uint64_t>(first) << 32) | second;
+    }
+
+    // Frozen compressed sparse row copy of connection_by_handle used by the
+    // path searches. Neighbours of handle h are in [offsets[h], offsets[h+1])
+    // in the same order as the adjacency lists. Rebuilt lazily on the first
+    // path query after the graph has changed.
+    struct CsrGraph {
+        std::vector<std::uint32_t> offsets;
+        std::vector<AffiliationHandle> neighbours;
+        std::vector<Weight> weights;
+    };
+    CsrGraph csr;
+    bool csr_dirty = true;
+    // The graph the path searches run on, from csr or a mapped snapshot
+    struct GraphView {
+        ArrayView<std::uint32_t> offsets;
+        ArrayView<AffiliationHandle> neighbours;
+        ArrayView<Weight> weights;
+    };
+    GraphView connection_graph();
+
+    // Scratch arrays for path searches, indexed by handle and reused between
+    // queries. An entry is valid only if its stamp equals the current
+    // generation, so starting a new search doesn't clear anything.
+    struct SearchState {
+        std::vector<std::uint32_t> stamp;
+        std::vector<AffiliationHandle> parent;
+        std::vector<std::uint32_t> parent_edge;
+        std::vector<std::uint32_t> depth;
+        std::vector<double> cost;
+        std::vector<std::uint32_t> closed;
+        std::uint32_t generation = 0;
+
+        void begin(std::size_t node_count){
+            if (stamp.size() < node_count) {
+                stamp.resize(node_count, 0);
+                parent.resize(node_count);
+                parent_edge.resize(node_count);
+                depth.resize(node_count);
+                cost.resize(node_count);
+                closed.resize(node_count, 0);
+            }
+            if (++generation == 0) {
+                std::fill(stamp.begin(), stamp.end(), 0);
+                std::fill(closed.begin(), closed.end(), 0);
+                generation = 1;
+            }
+        }
+        bool visited(AffiliationHandle handle) const {
+            return stamp[handle] == generation;
+        }
+        bool is_closed(AffiliationHandle handle) const {
+            return closed[handle] == generation;
+        }
+        void close(AffiliationHandle handle){
+            closed[handle] = generation;
+        }
+        void visit(AffiliationHandle handle, AffiliationHandle from, std::uint32_t edge, std::uint32_t hops){
+            stamp[handle] = generation;
+            parent[handle] = from;
+            parent_edge[handle] = edge;
+            depth[handle] = hops;
+        }
+    };
+    SearchState forward_search;
+    SearchState backward_search;
+    std::vector<AffiliationHandle> frontier;
+    std::vector<AffiliationHandle> other_frontier;
+    std::vector<AffiliationHandle> next_frontier;
+    unsigned int last_search_expansions = 0;
+    // Only connections with weight >= min_weight are used
+    Path bidirectional_bfs(AffiliationHandle source, AffiliationHandle target, Weight min_weight = 0);
+
+    // Maximum spanning forest of the connection graph stored as parent
+    // pointers, msf_weight[h] being the weight of the edge h - msf_parent[h].
+    // The path between two affiliations in it has the largest possible
+    // minimum weight. Kept up to date by connect() once built.
+    std::vector<AffiliationHandle> msf_parent;
+    std::vector<Weight> msf_weight;
+    bool msf_dirty = true;
+    SearchState tree_marks;
+    void rebuild_spanning_forest();
+    void update_spanning_forest(AffiliationHandle first, AffiliationHandle second, Weight weight);
+    void reroot_spanning_tree(AffiliationHandle handle);
+    // Finds the minimum weight on the forest path between the two handles and
+    // the lower endpoint of that edge. Returns false if they're in different trees.
+    bool spanning_path_minimum(AffiliationHandle first, AffiliationHandle second, Weight& minimum, AffiliationHandle& minimum_child);
+
+    // Min-heap of (estimated total cost, handle), reused between searches
+    std::vector<std::pair<double, AffiliationHandle>> search_heap;
+    bool shortest_path_heuristic = true;
+    double coord_distance(AffiliationHandle from, AffiliationHandle to) const {
+        Coord from_xy = affiliation_xy(from);
+        Coord to_xy = affiliation_xy(to);
+        double dx = static_cast<double>(from_xy.x) - to_xy.x;
+        double dy = static_cast<double>(from_xy.y) - to_xy.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+    PathWithDist shortest_path_search(AffiliationHandle source, AffiliationHandle target);
+
+    // Uniform grid over the coordinates of existing affiliations for nearest
+    // neighbour queries. Cells live in a hashmap keyed by cell coordinates so
+    // the coordinate range doesn't matter. Kept current by add/change/remove
+    // once built, and rebuilt with a new cell size when the number of
+    // affiliations has changed by more than a factor of two.
+    struct SpatialGrid {
+        int cell_size = 0; // 0 when not built
+        std::size_t count = 0;
+        std::size_t built_count = 0;
+        // Bounding box of all cells used since the last rebuild
+        int min_x = 0, max_x = -1, min_y = 0, max_y = -1;
+        std::unordered_map<std::uint64_t, std::vector<AffiliationHandle>> cells;
+    };
+    SpatialGrid grid;
+    int grid_cell(int value) const {
+        // Floor division so that negative coordinates get their own cells
+        int cell = value / grid.cell_size;
+        return (value % grid.cell_size < 0) ? cell - 1 : cell;
+    }
+    static std::uint64_t grid_key(int cell_x, int cell_y) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell_x)) << 32) | static_cast<std::uint32_t>(cell_y);
+    }
+    void rebuild_grid();
+    // Rebuilds the grid if it isn't built or its cell size no longer fits
+    void ensure_grid();
+    void grid_insert(AffiliationHandle handle);
+    void grid_erase(AffiliationHandle handle);
+    // The k existing affiliations closest to xy, ordered by distance, then
+    // y coordinate, then id
+    std::vector<AffiliationHandle> grid_nearest(Coord xy, std::size_t k);
+    // That order for (squared distance, handle) pairs
+    bool nearer(const std::pair<long long, AffiliationHandle>& a, const std::pair<long long, AffiliationHandle>& b) const {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        }
+        if (affiliations.ys[a.second] != affiliations.ys[b.second]) {
+            return affiliations.ys[a.second] < affiliations.ys[b.second];
+        }
+        return affiliations.id(a.second) < affiliations.id(b.second);
+    }
+
+    // Squared distances of all slots to one point, computed in a single pass
+    // by the widest kernel the CPU supports unless set_distance_kernel says
+    // otherwise
+    enum class DistanceKernel { SCALAR, SSE2, AVX2 };
+    DistanceKernel distance_kernel = DistanceKernel::SCALAR;
+    std::vector<long long> distance_scratch;
+    void square_distances(Coord xy);
+
+    static long long square_distance(Coord xy){
+        return static_cast<long long>(xy.x) * xy.x + static_cast<long long>(xy.y) * xy.y;
+    }
+    AffiliationHandle find_handle(const AffiliationID& id) const {
+        if (mapped.active()) {
+            return mapped.find_affiliation(id);
+        }
+        auto it = affiliation_handles.find(id);
+        return it != affiliation_handles.end() ? it->second : NO_HANDLE;
+    }
+    // Returns the handle of an existing affiliation, NO_HANDLE otherwise
+    AffiliationHandle find_existing(const AffiliationID& id) const {
+        AffiliationHandle handle = find_handle(id);
+        return (handle != NO_HANDLE && affiliation_exists(handle)) ? handle : NO_HANDLE;
+    }
+    // Per handle accessors that also work on a mapped snapshot
+    bool affiliation_exists(AffiliationHandle handle) const {
+        return mapped.active() ? (mapped.affiliation_flags[handle] & 1) != 0 : affiliations.exists[handle] != 0;
+    }
+    Coord affiliation_xy(AffiliationHandle handle) const {
+        return mapped.active() ? mapped.affiliation_coords[handle] : affiliations.xy(handle);
+    }
+    AffiliationID affiliation_id(AffiliationHandle handle) const {
+        return AffiliationID(mapped.active() ? mapped.affiliation_id(handle) : affiliations.id(handle));
+    }
+    AffiliationHandle intern(const AffiliationID& id){
+        auto [it, inserted] = affiliation_handles.try_emplace(id, static_cast<AffiliationHandle>(affiliations.size()));
+        if (inserted) {
+            affiliations.append(id);
+            affiliation_publications.emplace_back();
+            affiliation_publications_by_year.emplace_back();
+            connection_by_handle.emplace_back();
+            msf_parent.push_back(NO_HANDLE);
+            msf_weight.push_back(NO_WEIGHT);
+            csr_dirty = true;
+        }
+        return it->second;
+    }
+    Connection to_connection(const Link& link) const {
+        return {affiliation_id(link.aff1), affiliation_id(link.aff2), link.weight};
+    }
+    // The other end of a link as seen from handle
+    static AffiliationHandle link_other(const Link& link, AffiliationHandle handle) {
+        return link.aff1 == handle ? link.aff2 : link.aff1;
+    }
+    Connection to_connection(AffiliationHandle from, AffiliationHandle to, Weight weight) const {
+        return {affiliation_id(from), affiliation_id(to), weight};
+    }
+    void connect(AffiliationHandle first, AffiliationHandle second);
+    void create_connection(const Publication& pub, AffiliationHandle aff_to_fix = NO_HANDLE){
+        if (aff_to_fix == NO_HANDLE) {
+            for (size_t i = 0; i < pub.by_affiliations.size(); ++i) {
+                for (size_t j = i + 1; j < pub.by_affiliations.size(); ++j) {
+                    if (pub.by_affiliations[i] == pub.by_affiliations[j]) {
+                        break;
+                    }
+                    connect(pub.by_affiliations[i], pub.by_affiliations[j]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < pub.by_affiliations.size(); ++i) {
+                if (pub.by_affiliations[i] == aff_to_fix) {
+                    break;
+                }
+                connect(pub.by_affiliations[i], aff_to_fix);
+            }
+        }
+    }
+    std::vector<PublicationID> get_common_publication(AffiliationID id1, AffiliationID id2){
+        std::vector<PublicationID> pub1 = get_publications(id1);
+            std::vector<PublicationID> pub2 = get_publications(id2);
+
+            std::vector<PublicationID> commonPublications;
+            if (id1 == id2) {
+                return commonPublications;
+            }
+            for (const PublicationID id : pub1) {
+                if (std::find(pub2.begin(), pub2.end(), id) != pub2.end()) {
+                    commonPublications.push_back(id);
+                }
+            }
+
+            return commonPublications;
+    }
+    // Depth first search with an explicit stack of (affiliation, next edge
+    // to try). Visits neighbours in the same order as the recursive version.
+    std::vector<std::pair<AffiliationHandle, std::uint32_t>> dfs_stack;
+    bool find_path(AffiliationHandle source, AffiliationHandle target, Path& path);
+
+};
+
+#endif // DATASTRUCTURES_HH